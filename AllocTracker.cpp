@@ -0,0 +1,255 @@
+#include "AllocTracker.h"
+
+#include <new>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <iomanip>
+#include <cstdlib>
+using namespace std;
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <execinfo.h>
+#endif
+
+#include "Constants.h"
+
+// Frames of operator new and allocated() itself, left out of every stack
+static const int SKIP_FRAMES = 2;
+
+// Everything here is zero initialised before any constructor runs, so
+// allocations during static initialisation are safe to count
+struct Site
+{
+	std::atomic<size_t> key;   // Hash of the frames, 0 while the slot is free
+	void *frames[ALLOC_SITE_DEPTH];
+	int depth;
+	std::atomic<long long> count;
+	std::atomic<long long> bytes;
+};
+
+static std::atomic<bool> enabled;
+static std::atomic<long long> allocations;
+static std::atomic<long long> frees;
+static std::atomic<long long> bytes;
+static std::atomic<long long> droppedSamples;
+static Site sites[ALLOC_SITE_SLOTS];
+
+static thread_local long long threadAllocations;
+static thread_local long long threadFrees;
+static thread_local long long threadBytes;
+static thread_local unsigned int sampleCounter;
+static thread_local bool sampling;
+
+static int captureStack(void **frames)
+{
+#if defined(_WIN32)
+	return CaptureStackBackTrace(SKIP_FRAMES, ALLOC_SITE_DEPTH, frames, nullptr);
+#elif defined(__linux__)
+	void *all[ALLOC_SITE_DEPTH + SKIP_FRAMES];
+	int n = backtrace(all, ALLOC_SITE_DEPTH + SKIP_FRAMES) - SKIP_FRAMES;
+	for (int i = 0; i < n; ++i) frames[i] = all[i + SKIP_FRAMES];
+	return max(0, n);
+#else
+	frames[0] = __builtin_return_address(0);
+	return 1;
+#endif
+}
+
+static void sample(const size_t &size)
+{
+	void *frames[ALLOC_SITE_DEPTH];
+	int depth = captureStack(frames);
+
+	// FNV-1a over the return addresses
+	size_t key = 14695981039346656037ull & (size_t)-1;
+	for (int i = 0; i < depth; ++i)
+	{
+		key ^= (size_t)frames[i];
+		key *= (size_t)1099511628211ull;
+	}
+	key |= 1;
+
+	for (int probe = 0; probe < ALLOC_SITE_SLOTS; ++probe)
+	{
+		Site &s = sites[(key + probe) % ALLOC_SITE_SLOTS];
+		size_t expected = 0;
+		if (s.key.load(memory_order_relaxed) != key && !s.key.compare_exchange_strong(expected, key)) continue;
+
+		if (expected == 0 && s.count.load(memory_order_relaxed) == 0)
+		{
+			copy(frames, frames + depth, s.frames);
+			s.depth = depth;
+		}
+		s.count.fetch_add(1, memory_order_relaxed);
+		s.bytes.fetch_add(size, memory_order_relaxed);
+		return;
+	}
+
+	droppedSamples.fetch_add(1, memory_order_relaxed);
+}
+
+void AllocTracker::setEnabled(const bool &on)
+{
+#if defined(__linux__)
+	// The first backtrace loads the unwinder, which allocates
+	void *frames[1];
+	if (on) backtrace(frames, 1);
+#endif
+	enabled = on;
+}
+
+bool AllocTracker::isEnabled()
+{
+	return enabled;
+}
+
+AllocTracker::Counts AllocTracker::total()
+{
+	Counts c = { allocations.load(memory_order_relaxed), frees.load(memory_order_relaxed), bytes.load(memory_order_relaxed) };
+	return c;
+}
+
+AllocTracker::Counts AllocTracker::thisThread()
+{
+	Counts c = { threadAllocations, threadFrees, threadBytes };
+	return c;
+}
+
+void AllocTracker::allocated(const size_t &size)
+{
+	if (!enabled.load(memory_order_relaxed) || sampling) return;
+
+	allocations.fetch_add(1, memory_order_relaxed);
+	bytes.fetch_add(size, memory_order_relaxed);
+	++threadAllocations;
+	threadBytes += size;
+
+	if (++sampleCounter % ALLOC_SAMPLE_EVERY == 0)
+	{
+		sampling = true;
+		sample(size);
+		sampling = false;
+	}
+}
+
+void AllocTracker::freed()
+{
+	if (!enabled.load(memory_order_relaxed) || sampling) return;
+
+	frees.fetch_add(1, memory_order_relaxed);
+	++threadFrees;
+}
+
+void AllocTracker::printSites(ostream &out, const int &count)
+{
+	// Reporting allocates, keep it out of the counts
+	sampling = true;
+
+	vector<const Site*> used;
+	for (const auto &s : sites)
+	{
+		if (s.count.load(memory_order_relaxed) > 0) used.push_back(&s);
+	}
+	sort(used.begin(), used.end(), [](const Site *a, const Site *b) { return a->count > b->count; });
+
+	out << "Sampled allocation sites, 1 in " << ALLOC_SAMPLE_EVERY;
+	if (droppedSamples > 0) out << ", " << droppedSamples << " samples dropped";
+	out << endl;
+
+	for (size_t i = 0; i < used.size() && (int)i < count; ++i)
+	{
+		const Site &s = *used[i];
+		out << "  " << s.count * ALLOC_SAMPLE_EVERY << " allocations, " << s.bytes * ALLOC_SAMPLE_EVERY << " bytes" << endl;
+
+#if defined(__linux__)
+		char **names = backtrace_symbols(s.frames, s.depth);
+		for (int f = 0; f < s.depth; ++f) out << "    " << (names != nullptr ? names[f] : "?") << endl;
+		free(names);
+#else
+		for (int f = 0; f < s.depth; ++f) out << "    0x" << hex << (size_t)s.frames[f] << dec << endl;
+#endif
+	}
+
+	sampling = false;
+}
+
+void AllocTracker::resetSites()
+{
+	for (auto &s : sites)
+	{
+		s.count = 0;
+		s.bytes = 0;
+		s.key = 0;
+	}
+	droppedSamples = 0;
+}
+
+void* operator new(size_t size)
+{
+	void *p = malloc(size > 0 ? size : 1);
+	if (p == nullptr) throw bad_alloc();
+	AllocTracker::allocated(size);
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	void *p = malloc(size > 0 ? size : 1);
+	if (p == nullptr) throw bad_alloc();
+	AllocTracker::allocated(size);
+	return p;
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept
+{
+	void *p = malloc(size > 0 ? size : 1);
+	if (p != nullptr) AllocTracker::allocated(size);
+	return p;
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept
+{
+	void *p = malloc(size > 0 ? size : 1);
+	if (p != nullptr) AllocTracker::allocated(size);
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	if (p == nullptr) return;
+	AllocTracker::freed();
+	free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	if (p == nullptr) return;
+	AllocTracker::freed();
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	operator delete(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+	operator delete[](p);
+}
+
+void operator delete(void *p, const nothrow_t&) noexcept
+{
+	operator delete(p);
+}
+
+void operator delete[](void *p, const nothrow_t&) noexcept
+{
+	operator delete[](p);
+}
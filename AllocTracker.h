@@ -0,0 +1,40 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <ostream>
+using namespace std;
+
+/*
+ * Counts heap allocations through replaced global operator new and delete.
+ * Off until enabled, after which every allocation bumps a process wide and
+ * a per thread counter, and every ALLOC_SAMPLE_EVERY-th one records the
+ * call stack it came from into a fixed table, so tracking never allocates
+ * itself. Per frame numbers are differences of the counts between frames.
+ */
+class AllocTracker
+{
+public:
+	struct Counts
+	{
+		long long allocations;
+		long long frees;
+		long long bytes;
+	};
+
+	static void setEnabled(const bool &enabled);
+	static bool isEnabled();
+
+	// Since the process started, everything while enabled
+	static Counts total();
+	static Counts thisThread();
+
+	// The most frequent sampled call stacks, innermost frame first
+	static void printSites(ostream &out, const int &count);
+	static void resetSites();
+
+	// Called by the operators
+	static void allocated(const size_t &bytes);
+	static void freed();
+};
+
+#endif /* ALLOC_TRACKER_H */
@@ -0,0 +1,198 @@
+#include "AsyncMarcher.h"
+
+#include <iostream>
+
+#include <SFML/Window/Context.hpp>
+#include <SFML/Graphics/RectangleShape.hpp>
+#include <SFML/System/Clock.hpp>
+
+#include "GLFunctions.h"
+#include "Constants.h"
+
+AsyncMarcher::AsyncMarcher()
+	: vertSource()
+	, fragSource()
+	, setUniforms()
+	, worker()
+	, requestMutex()
+	, requestCond()
+	, pending()
+	, pendingSize()
+	, requested(0)
+	, marched(0)
+	, stopWorker(false)
+	, frames()
+	, failed(false)
+	, frameTime(0.0f)
+	, running(false)
+{}
+
+AsyncMarcher::~AsyncMarcher()
+{
+	stop();
+}
+
+void AsyncMarcher::start(const string &vertSource, const string &fragSource, UniformFunc setUniforms)
+{
+	if (running) return;
+
+	this->vertSource = vertSource;
+	this->fragSource = fragSource;
+	this->setUniforms = setUniforms;
+
+	requested = 0;
+	marched = 0;
+	stopWorker = false;
+	failed = false;
+	frameTime = 0.0f;
+	worker = thread(&AsyncMarcher::work, this);
+	running = true;
+}
+
+void AsyncMarcher::stop()
+{
+	if (!running) return;
+
+	{
+		lock_guard<mutex> lock(requestMutex);
+		stopWorker = true;
+	}
+	requestCond.notify_one();
+	worker.join();
+	running = false;
+}
+
+bool AsyncMarcher::isRunning() const
+{
+	return running;
+}
+
+bool AsyncMarcher::isFailed() const
+{
+	return failed;
+}
+
+void AsyncMarcher::request(const ViewState &view, const sf::Vector2u &size)
+{
+	{
+		lock_guard<mutex> lock(requestMutex);
+		pending = view;
+		pendingSize = size;
+		++requested;
+	}
+	requestCond.notify_one();
+}
+
+const AsyncMarcher::Frame* AsyncMarcher::getFrame()
+{
+	frames.consume();
+
+	// Slots the worker has not rendered to, or has freed on stopping, are empty
+	const Frame &frame = frames.getReadBuffer();
+	return frame.color != nullptr ? &frame : nullptr;
+}
+
+float AsyncMarcher::getFrameTime() const
+{
+	return frameTime;
+}
+
+void AsyncMarcher::work()
+{
+	// Everything below lives in this thread's contexts, which share their
+	// textures with the window's
+	sf::Context context;
+	glext::load();
+
+	sf::Shader shader;
+	if (!glext::hasMultipleRenderTargets() || !shader.loadFromMemory(vertSource, fragSource))
+	{
+		failed = true;
+		return;
+	}
+
+	vector<Frame*> owned;
+	sf::RectangleShape quad;
+	sf::Clock clock;
+
+	while (true)
+	{
+		ViewState view;
+		sf::Vector2u size;
+		{
+			unique_lock<mutex> lock(requestMutex);
+			requestCond.wait(lock, [this]{ return stopWorker || requested != marched; });
+			if (stopWorker) break;
+
+			view = pending;
+			size = pendingSize;
+			marched = requested;
+		}
+
+		clock.restart();
+
+		Frame *frame = &frames.getWriteBuffer();
+		if (frame->color == nullptr) owned.push_back(frame);
+
+		if (!prepare(*frame, size))
+		{
+			failed = true;
+			break;
+		}
+
+		sf::RenderTexture &target = *frame->color;
+		target.setActive(true);
+		setUniforms(shader, view, size);
+		shader.setUniform("projViewMatrix", (sf::Glsl::Mat4)target.getView().getTransform().getMatrix());
+
+		quad.setSize(sf::Vector2f(size));
+		target.clear(sf::Color::Black);
+		target.draw(quad, &shader);
+
+		// The window's context may sample the frame as soon as it is published
+		glFinish();
+		frame->view = view;
+		frames.publish();
+
+		float ms = clock.getElapsedTime().asSeconds() * 1000.0f;
+		float smoothed = frameTime;
+		frameTime = smoothed == 0.0f ? ms : smoothed + (ms - smoothed) * ASYNC_MARCH_SMOOTHING;
+	}
+
+	// The contexts behind these are this thread's, release them here
+	for (auto f : owned)
+	{
+		delete f->color;
+		delete f->depth;
+		f->color = nullptr;
+		f->depth = nullptr;
+	}
+}
+
+// Sizes a frame's targets and attaches the depth target as a second output
+bool AsyncMarcher::prepare(Frame &frame, const sf::Vector2u &size) const
+{
+	if (frame.color != nullptr && frame.color->getSize() == size) return true;
+
+	delete frame.color;
+	delete frame.depth;
+	frame.color = new sf::RenderTexture();
+	frame.depth = new sf::Texture();
+
+	if (!frame.color->create(size.x, size.y) || !frame.depth->create(size.x, size.y)) return false;
+	frame.color->setSmooth(true);
+
+	// The render texture's framebuffer stays bound while its context is active
+	frame.color->setActive(true);
+
+	// SFML only makes RGBA8 textures, respecify the storage as one float per texel
+	sf::Texture::bind(frame.depth);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, size.x, size.y, 0, GL_RED, GL_FLOAT, nullptr);
+	sf::Texture::bind(nullptr);
+
+	glext::glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, frame.depth->getNativeHandle(), 0);
+	const GLenum buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glext::glDrawBuffers(2, buffers);
+
+	return glext::glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
@@ -0,0 +1,83 @@
+#ifndef ASYNC_MARCHER_H
+#define ASYNC_MARCHER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+using namespace std;
+
+#include <SFML/Graphics/RenderTexture.hpp>
+#include <SFML/Graphics/Shader.hpp>
+#include <SFML/Graphics/Texture.hpp>
+
+#include "TripleBuffer.h"
+#include "ViewState.h"
+
+/*
+ * Marches frames on a worker thread with its own GL context, so the display
+ * loop never waits on a slow frame. Each frame is rendered to a colour target
+ * plus a float target holding the hit distance of every pixel, which is what
+ * the display needs to reproject it to a newer camera. The worker always
+ * marches the newest view it was asked for, finished frames are handed back
+ * through a triple buffer.
+ */
+class AsyncMarcher
+{
+public:
+	typedef std::function<void(sf::Shader&, const ViewState&, const sf::Vector2u&)> UniformFunc;
+
+	struct Frame
+	{
+		sf::RenderTexture *color;
+		sf::Texture *depth;
+		ViewState view;
+	};
+
+	AsyncMarcher();
+	~AsyncMarcher();
+
+	// The worker compiles its own copy of the march shader from these sources
+	void start(const string &vertSource, const string &fragSource, UniformFunc setUniforms);
+	void stop();
+	bool isRunning() const;
+
+	// Set by the worker when its context cannot render frames with depth
+	bool isFailed() const;
+
+	// Latest wins, a view replaces any the worker has not started on
+	void request(const ViewState &view, const sf::Vector2u &size);
+
+	// Newest finished frame, null until the first one is done
+	const Frame* getFrame();
+
+	// Smoothed wall time of the worker's frames in ms
+	float getFrameTime() const;
+
+private:
+	string vertSource;
+	string fragSource;
+	UniformFunc setUniforms;
+
+	thread worker;
+	mutex requestMutex;
+	condition_variable requestCond;
+	ViewState pending;
+	sf::Vector2u pendingSize;
+	int requested;
+	int marched;
+	bool stopWorker;
+
+	TripleBuffer<Frame> frames;
+	std::atomic<bool> failed;
+	std::atomic<float> frameTime;
+	bool running;
+
+	void work();
+	bool prepare(Frame &frame, const sf::Vector2u &size) const;
+};
+
+#endif /* ASYNC_MARCHER_H */
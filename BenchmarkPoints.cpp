@@ -0,0 +1,63 @@
+#include "BenchmarkPoints.h"
+
+#include "Mandelbulb.h"
+#include "Constants.h"
+
+Vector3f randomInBall(mt19937 &rng, const float &radius)
+{
+	uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	Vector3f v;
+	do v.set(unit(rng), unit(rng), unit(rng)); while (v.dot(v) > 1.0f);
+	return v * radius;
+}
+
+vector<Vector3f> surfacePoints(mt19937 &rng, const int &count)
+{
+	vector<Vector3f> points;
+
+	// Rays from outside the bulb toward its core, stopped at the surface
+	while ((int)points.size() < count)
+	{
+		Vector3f ro = Vector3f::normalize(randomInBall(rng, 1.0f)) * 2.5f;
+		Vector3f rd = Vector3f::normalize(randomInBall(rng, 0.5f) - ro);
+
+		float t = 0.0f;
+		for (int i = 0; i < 256 && t < 5.0f; ++i)
+		{
+			Vector3f p = ro + rd * t;
+			float d = sdfMandelbulb(p, POWER);
+			if (d < BENCH_SURFACE_DISTANCE)
+			{
+				points.push_back(p);
+				break;
+			}
+			t += d;
+		}
+	}
+
+	return points;
+}
+
+vector<Vector3f> farPoints(mt19937 &rng, const int &count)
+{
+	vector<Vector3f> points;
+	while ((int)points.size() < count)
+	{
+		Vector3f p = randomInBall(rng, 2.0f * MAX_BAILOUT);
+		if (p.length() > MAX_BAILOUT) points.push_back(p);
+	}
+	return points;
+}
+
+// The estimate is negative once the orbit ends inside the unit sphere
+vector<Vector3f> interiorPoints(mt19937 &rng, const int &count)
+{
+	vector<Vector3f> points;
+	while ((int)points.size() < count)
+	{
+		Vector3f p = randomInBall(rng, 1.2f);
+		if (sdfMandelbulb(p, POWER) < 0.0f) points.push_back(p);
+	}
+	return points;
+}
@@ -0,0 +1,25 @@
+#ifndef BENCHMARK_POINTS_H
+#define BENCHMARK_POINTS_H
+
+#include <vector>
+#include <random>
+using namespace std;
+
+#include "Vector3f.h"
+
+// Sample points around the bulb for the offline tools, all drawn from rng so
+// a fixed seed gives the same points on every run.
+
+// Within BENCH_SURFACE_DISTANCE of the surface, where rays toward the core stop
+vector<Vector3f> surfacePoints(mt19937 &rng, const int &count);
+
+// Outside the bailout radius, up to twice as far
+vector<Vector3f> farPoints(mt19937 &rng, const int &count);
+
+// Inside, where the estimate is negative
+vector<Vector3f> interiorPoints(mt19937 &rng, const int &count);
+
+// Uniform in a ball of the given radius around the origin
+Vector3f randomInBall(mt19937 &rng, const float &radius);
+
+#endif /* BENCHMARK_POINTS_H */
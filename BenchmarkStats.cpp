@@ -0,0 +1,48 @@
+#include "BenchmarkStats.h"
+
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+// Two sided 97.5% quantiles of Student's t for 1 to 30 degrees of freedom
+static const double T_975[30] = {
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+SampleSummary summarize(const vector<double> &samples)
+{
+	SampleSummary s = { (int)samples.size(), 0.0, 0.0, 0.0, 0.0, 0.0 };
+	if (samples.empty()) return s;
+
+	s.min = s.max = samples[0];
+	for (double x : samples)
+	{
+		s.mean += x;
+		s.min = min(s.min, x);
+		s.max = max(s.max, x);
+	}
+	s.mean /= s.count;
+
+	if (s.count < 2) return s;
+
+	double sq = 0.0;
+	for (double x : samples) sq += (x - s.mean) * (x - s.mean);
+	s.stddev = sqrt(sq / (s.count - 1));
+
+	int dof = s.count - 1;
+	double t = dof <= 30 ? T_975[dof - 1] : 1.96;
+	s.ci95 = t * s.stddev / sqrt((double)s.count);
+
+	return s;
+}
+
+double percentile(vector<double> samples, const double &p)
+{
+	if (samples.empty()) return 0.0;
+
+	int k = min((int)samples.size() - 1, (int)(p * samples.size()));
+	nth_element(samples.begin(), samples.begin() + k, samples.end());
+	return samples[k];
+}
@@ -0,0 +1,24 @@
+#ifndef BENCHMARK_STATS_H
+#define BENCHMARK_STATS_H
+
+#include <vector>
+using namespace std;
+
+// Spread of repeated measurements. ci95 is the half width of the 95%
+// confidence interval of the mean, from Student's t distribution.
+struct SampleSummary
+{
+	int count;
+	double mean;
+	double stddev;
+	double ci95;
+	double min;
+	double max;
+};
+
+SampleSummary summarize(const vector<double> &samples);
+
+// p in [0, 1], nearest rank
+double percentile(vector<double> samples, const double &p);
+
+#endif /* BENCHMARK_STATS_H */
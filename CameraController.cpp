@@ -14,6 +14,8 @@ using namespace std;
 CameraController::CameraController(float viewportWidth, float viewportHeight)
 	: camera(new Camera(viewportWidth, viewportHeight))
 	, speed(CAM_UNIT_SPEED)
+	, tickVelocity(0.0f, 0.0f, 0.0f)
+	, heldVelocity(0.0f, 0.0f, 0.0f)
 {}
 
 float CameraController::getSpeed() const
@@ -21,8 +23,22 @@ float CameraController::getSpeed() const
 	return speed;
 }
 
+void CameraController::setSpeed(const float &speed)
+{
+	this->speed = speed;
+}
+
+Vector3f CameraController::getVelocity() const
+{
+	return tickVelocity;
+}
+
+// Held keys are reported before update, so this closes the tick
 void CameraController::update(const float dt)
-{}
+{
+	tickVelocity = heldVelocity;
+	heldVelocity = Vector3f(0.0f, 0.0f, 0.0f);
+}
 
 void CameraController::keyHeld(const sf::Keyboard::Key &key, const float dt)
 {
@@ -37,6 +53,7 @@ void CameraController::keyHeld(const sf::Keyboard::Key &key, const float dt)
 		{
 			Vector3f tmp(camera->direction);
 			tmp.normalize();
+			heldVelocity += tmp * abs(velocity);
 			tmp *= abs(offset);
 			camera->position += tmp;
 		}
@@ -47,6 +64,7 @@ void CameraController::keyHeld(const sf::Keyboard::Key &key, const float dt)
 		{
 			Vector3f tmp(camera->direction);
 			tmp.normalize();
+			heldVelocity -= tmp * abs(velocity);
 			tmp *= abs(offset);
 			camera->position -= tmp;
 		}
@@ -82,18 +100,23 @@ const float clamp(const float &n, const float &lower, const float &upper) {
   return std::max(lower, std::min(n, upper));
 }
 
-void CameraController::mouseMoved(const int mouseX, const int mouseY, const int dx, const int dy, const float dt)
+void CameraController::look(Vector3f &direction, Vector3f &up, const int &dx, const int &dy) const
 {
 	float deltaX = (float)dx * CAM_DEGREES_PER_PIXEL;
 	float deltaY = (float)dy * CAM_DEGREES_PER_PIXEL;
 
-	camera->direction.rotate(camera->up, deltaX);
+	direction.rotate(up, deltaX);
 
-	Vector3f right(camera->direction);
-	right.cross(camera->up).normalize();
+	Vector3f right(direction);
+	right.cross(up).normalize();
 
-	camera->direction.rotate(right, deltaY);
-	camera->up.rotate(right, deltaY);
+	direction.rotate(right, deltaY);
+	up.rotate(right, deltaY);
+}
+
+void CameraController::mouseMoved(const int mouseX, const int mouseY, const int dx, const int dy, const float dt)
+{
+	look(camera->direction, camera->up, dx, dy);
 }
 
 void CameraController::mouseScrolled(const float scrollDelta, const int mouseX, const int mouseY, const float timeDelta)
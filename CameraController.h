@@ -13,6 +13,13 @@ public:
 	CameraController(float viewportWidth, float viewportHeight);
 
 	float getSpeed() const;
+	void setSpeed(const float &speed);
+
+	// Movement from W/S during the last update, in units per second
+	Vector3f getVelocity() const;
+
+	// Turns a view basis the way mouseMoved turns the camera
+	void look(Vector3f &direction, Vector3f &up, const int &dx, const int &dy) const;
 
 	void update(const float dt);
 
@@ -28,6 +35,8 @@ public:
 
 private:
 	float speed;
+	Vector3f tickVelocity;
+	Vector3f heldVelocity;
 };
 
 
@@ -0,0 +1,150 @@
+#include "CameraPath.h"
+
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+using namespace std;
+
+// File layout: magic, version, key count, then per key dt, position,
+// orientation and speed as little endian floats.
+static const char PATH_MAGIC[4] = { 'M', 'B', 'F', 'T' };
+static const unsigned int PATH_VERSION = 1;
+static const int FLOATS_PER_KEY = 9;
+
+CameraPath::CameraPath()
+	: keys()
+{}
+
+void CameraPath::clear()
+{
+	keys.clear();
+}
+
+void CameraPath::add(const Camera &camera, const float &speed, const float &dt)
+{
+	Vector3f right = Vector3f::cross(camera.up, camera.direction).normalize();
+	Vector3f up = Vector3f::cross(camera.direction, right).normalize();
+	Vector3f forward = Vector3f::normalize(camera.direction);
+
+	Key k;
+	k.time = keys.empty() ? 0.0f : keys.back().time + dt;
+	k.position = camera.position;
+	k.orientation.setFromAxes(right, up, forward);
+	k.speed = speed;
+	keys.push_back(k);
+}
+
+int CameraPath::size() const
+{
+	return (int)keys.size();
+}
+
+float CameraPath::getDuration() const
+{
+	return keys.empty() ? 0.0f : keys.back().time;
+}
+
+bool CameraPath::save(const string &filename) const
+{
+	ofstream out(filename.c_str(), ios::binary);
+	if (!out) return false;
+
+	unsigned int count = (unsigned int)keys.size();
+	out.write(PATH_MAGIC, sizeof(PATH_MAGIC));
+	out.write((const char*)&PATH_VERSION, sizeof(PATH_VERSION));
+	out.write((const char*)&count, sizeof(count));
+
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		const Key &k = keys[i];
+		float dt = i == 0 ? 0.0f : k.time - keys[i - 1].time;
+		float data[FLOATS_PER_KEY] = { dt
+		                             , k.position.x, k.position.y, k.position.z
+		                             , k.orientation.x, k.orientation.y, k.orientation.z, k.orientation.w
+		                             , k.speed };
+		out.write((const char*)data, sizeof(data));
+	}
+
+	return out.good();
+}
+
+bool CameraPath::load(const string &filename)
+{
+	ifstream in(filename.c_str(), ios::binary);
+	if (!in) return false;
+
+	char magic[4];
+	unsigned int version = 0, count = 0;
+	in.read(magic, sizeof(magic));
+	in.read((char*)&version, sizeof(version));
+	in.read((char*)&count, sizeof(count));
+	if (!in || memcmp(magic, PATH_MAGIC, sizeof(magic)) != 0 || version != PATH_VERSION)
+	{
+		cout << filename << " is not a camera path" << endl;
+		return false;
+	}
+
+	keys.clear();
+	keys.reserve(count);
+
+	float time = 0.0f;
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		float data[FLOATS_PER_KEY];
+		in.read((char*)data, sizeof(data));
+		if (!in) return false;
+
+		time += data[0];
+
+		Key k;
+		k.time = time;
+		k.position.set(data[1], data[2], data[3]);
+		k.orientation.set(data[4], data[5], data[6], data[7]);
+		k.speed = data[8];
+		keys.push_back(k);
+	}
+
+	return true;
+}
+
+static Vector3f catmullRom(const Vector3f &p0, const Vector3f &p1, const Vector3f &p2, const Vector3f &p3, const float &u)
+{
+	float u2 = u * u;
+	float u3 = u2 * u;
+	return ( p1 * 2.0f
+	       + (p2 - p0) * u
+	       + (p0 * 2.0f - p1 * 5.0f + p2 * 4.0f - p3) * u2
+	       + (p1 * 3.0f - p0 - p2 * 3.0f + p3) * u3 ) * 0.5f;
+}
+
+void CameraPath::sample(const float &time, Camera &camera, float &speed) const
+{
+	if (keys.empty()) return;
+
+	// First key after time, the segment runs from the key before it
+	vector<Key>::const_iterator after = upper_bound(keys.begin(), keys.end(), time,
+		[](const float &t, const Key &k) { return t < k.time; });
+
+	int last = (int)keys.size() - 1;
+	int i1 = max(0, (int)(after - keys.begin()) - 1);
+	int i2 = min(i1 + 1, last);
+	int i0 = max(i1 - 1, 0);
+	int i3 = min(i2 + 1, last);
+
+	float span = keys[i2].time - keys[i1].time;
+	float u = span > 0.0f ? (time - keys[i1].time) / span : 0.0f;
+	u = max(0.0f, min(1.0f, u));
+
+	camera.position = catmullRom(keys[i0].position, keys[i1].position, keys[i2].position, keys[i3].position, u);
+
+	Quaternion orientation(keys[i1].orientation);
+	orientation.slerp(keys[i2].orientation, u);
+
+	camera.direction.set(0.0f, 0.0f, 1.0f);
+	camera.up.set(0.0f, 1.0f, 0.0f);
+	orientation.transform(camera.direction);
+	orientation.transform(camera.up);
+
+	speed = keys[i1].speed + (keys[i2].speed - keys[i1].speed) * u;
+}
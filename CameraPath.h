@@ -0,0 +1,47 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "Camera.h"
+#include "Quaternion.h"
+#include "Vector3f.h"
+
+/*
+ * A recorded flythrough, one key per rendered frame. Keys store the camera
+ * orientation as a quaternion, which keeps the file compact (36 bytes a frame)
+ * and lets playback slerp between keys. Positions are interpolated along a
+ * Catmull-Rom spline through the recorded positions.
+ */
+class CameraPath
+{
+public:
+	CameraPath();
+
+	void clear();
+	void add(const Camera &camera, const float &speed, const float &dt);
+
+	int size() const;
+	float getDuration() const;
+
+	bool save(const string &filename) const;
+	bool load(const string &filename);
+
+	// Moves the camera to where the path is at the given time
+	void sample(const float &time, Camera &camera, float &speed) const;
+
+private:
+	struct Key
+	{
+		float time;
+		Vector3f position;
+		Quaternion orientation;
+		float speed;
+	};
+
+	vector<Key> keys;
+};
+
+#endif /* CAMERA_PATH_H */
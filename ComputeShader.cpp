@@ -0,0 +1,142 @@
+#include "ComputeShader.h"
+
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#include "GLFunctions.h"
+
+#ifndef GL_CURRENT_PROGRAM
+#define GL_CURRENT_PROGRAM 0x8B8D
+#endif
+
+ComputeShader::ComputeShader()
+	: program(0)
+	, uniforms()
+{}
+
+ComputeShader::~ComputeShader()
+{
+	if (program != 0) glext::glDeleteProgram(program);
+}
+
+bool ComputeShader::loadFromMemory(const string &source)
+{
+	glext::load();
+	if (!glext::hasComputeShaders()) return false;
+
+	const char *src = source.c_str();
+	GLuint shader = glext::glCreateShader(GL_COMPUTE_SHADER);
+	glext::glShaderSource(shader, 1, &src, nullptr);
+	glext::glCompileShader(shader);
+
+	GLint status = GL_FALSE;
+	glext::glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		GLint length = 0;
+		glext::glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+		vector<char> log(length + 1, '\0');
+		glext::glGetShaderInfoLog(shader, length, nullptr, &log[0]);
+		cout << "Failed to compile compute shader:" << endl << &log[0] << endl;
+		glext::glDeleteShader(shader);
+		return false;
+	}
+
+	GLuint linked = glext::glCreateProgram();
+	glext::glAttachShader(linked, shader);
+	glext::glLinkProgram(linked);
+	glext::glDeleteShader(shader);
+
+	glext::glGetProgramiv(linked, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		GLint length = 0;
+		glext::glGetProgramiv(linked, GL_INFO_LOG_LENGTH, &length);
+		vector<char> log(length + 1, '\0');
+		glext::glGetProgramInfoLog(linked, length, nullptr, &log[0]);
+		cout << "Failed to link compute shader:" << endl << &log[0] << endl;
+		glext::glDeleteProgram(linked);
+		return false;
+	}
+
+	if (program != 0) glext::glDeleteProgram(program);
+	program = linked;
+	uniforms.clear();
+	return true;
+}
+
+int ComputeShader::getUniformLocation(const string &name)
+{
+	map<string, int>::const_iterator it = uniforms.find(name);
+	if (it != uniforms.end()) return it->second;
+
+	int location = glext::glGetUniformLocation(program, name.c_str());
+	uniforms.insert(make_pair(name, location));
+	return location;
+}
+
+// Binds the program for the lifetime of the binder and restores whatever
+// program was bound before, the same way sf::Shader sets its uniforms.
+struct ProgramBinder
+{
+	GLint previous;
+
+	ProgramBinder(const unsigned int &program)
+		: previous(0)
+	{
+		glGetIntegerv(GL_CURRENT_PROGRAM, &previous);
+		glext::glUseProgram(program);
+	}
+
+	~ProgramBinder()
+	{
+		glext::glUseProgram(previous);
+	}
+};
+
+void ComputeShader::setUniform(const string &name, float x)
+{
+	if (program == 0) return;
+	ProgramBinder binder(program);
+	glext::glUniform1f(getUniformLocation(name), x);
+}
+
+void ComputeShader::setUniform(const string &name, int x)
+{
+	if (program == 0) return;
+	ProgramBinder binder(program);
+	glext::glUniform1i(getUniformLocation(name), x);
+}
+
+void ComputeShader::setUniform(const string &name, bool x)
+{
+	if (program == 0) return;
+	ProgramBinder binder(program);
+	glext::glUniform1i(getUniformLocation(name), x ? 1 : 0);
+}
+
+void ComputeShader::setUniform(const string &name, const sf::Glsl::Vec3 &v)
+{
+	if (program == 0) return;
+	ProgramBinder binder(program);
+	glext::glUniform3f(getUniformLocation(name), v.x, v.y, v.z);
+}
+
+void ComputeShader::dispatch(const unsigned int &texture, const unsigned int &groupsX, const unsigned int &groupsY)
+{
+	if (program == 0) return;
+
+	glext::glUseProgram(program);
+	glext::glBindImageTexture(0, texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	glext::glDispatchCompute(groupsX, groupsY, 1);
+
+	// The image is sampled by the next draw
+	glext::glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+	glext::glUseProgram(0);
+}
+
+unsigned int ComputeShader::getNativeHandle() const
+{
+	return program;
+}
@@ -0,0 +1,42 @@
+#ifndef COMPUTE_SHADER_H
+#define COMPUTE_SHADER_H
+
+#include <string>
+#include <map>
+using namespace std;
+
+#include <SFML/Graphics/Glsl.hpp>
+
+/*
+ * sf::Shader has no compute stage, this is the minimal equivalent built on the
+ * runtime loaded GL 4.3 entry points. The setUniform overloads mirror the ones
+ * of sf::Shader so uniform uploads can be shared between both.
+ */
+class ComputeShader
+{
+public:
+	ComputeShader();
+	~ComputeShader();
+
+	// Requires an active context. Returns false when compute shaders are
+	// unsupported or the source does not compile.
+	bool loadFromMemory(const string &source);
+
+	void setUniform(const string &name, float x);
+	void setUniform(const string &name, int x);
+	void setUniform(const string &name, bool x);
+	void setUniform(const string &name, const sf::Glsl::Vec3 &v);
+
+	// Runs the shader with the texture bound as image unit 0 (rgba8, write only)
+	void dispatch(const unsigned int &texture, const unsigned int &groupsX, const unsigned int &groupsY);
+
+	unsigned int getNativeHandle() const;
+
+private:
+	unsigned int program;
+	map<string, int> uniforms;
+
+	int getUniformLocation(const string &name);
+};
+
+#endif /* COMPUTE_SHADER_H */
@@ -2,11 +2,64 @@
 #define CONSTANTS_H
 
 #include "Vector3f.h"
+#include "PixelOrder.h"
 
 const bool IS_FULLSCREEN = false;
 const int DEFAULT_FPS = 60;
 const int INFO_FONT_SIZE_PX = 24;
 
+const bool THREADED_UPDATE = true;
+const float UPDATE_TICK_RATE = 240.0f;  // Input and simulation ticks per second when threaded
+const bool LATE_LATCH_INPUT = true;     // Read mouse look again right before drawing
+const float LATE_LATCH_SAMPLE_RATE = 1000.0f;  // Cursor reads per second between ticks when threaded
+const int LATENCY_TRACKER_RING = 1024;  // Input events that may wait to be displayed
+
+const int FRAME_STATS_HISTORY = 240;
+const int GPU_TIMER_LATENCY = 4;       // Frames a timer query may stay in flight
+const float GPU_TIMER_SMOOTHING = 0.1f;
+
+const int CAPTURE_PBO_COUNT = 3;       // Readbacks in flight before frames are dropped
+const int CAPTURE_QUEUE_DEPTH = 8;     // Frames buffered for the encoder thread
+
+const int COMPUTE_TILE_SIZE = 8;       // Must match local_size in mandelbulb.comp
+const float COMPUTE_VERIFY_PIXEL_TOLERANCE = 0.1f;
+const float COMPUTE_VERIFY_MAX_MISMATCH = 0.02f; // Fraction of pixels allowed over tolerance
+
+const float ASYNC_MARCH_SMOOTHING = 0.1f;
+
+const int CPU_TILE_SIZE = 32;
+const int CPU_RENDER_THREADS = 0;        // 0 uses every hardware thread
+const float CPU_RENDER_SCALE = 0.5f;    // Fraction of the window size the CPU backend renders at
+const float CPU_FRAME_TIME_SMOOTHING = 0.1f;
+const float CPU_TILE_REUSE_PIXELS = 0.5f; // How far a finished tile may move and still be shown
+const bool CPU_SPECULATE = true;         // Idle workers prerender where W/S will take the camera
+const bool CPU_PACKET_MARCH = true;      // March rays in packets through the batched estimator
+const int CPU_PACKET_WIDTH = 4;          // 8 or 16 rays per packet keep the SIMD lanes busy
+const int CPU_PACKET_HEIGHT = 2;
+const float CPU_PACKET_MIN_ACTIVE = 0.5f; // Fraction of a packet still marching before it splits into single rays
+const bool CPU_WAVEFRONT_MARCH = false;  // March whole tiles as compacted wavefronts, overrides packets
+const PixelOrder::Curve CPU_TILE_ORDER = PixelOrder::Hilbert;  // Order tiles are handed to the workers
+const PixelOrder::Curve CPU_PIXEL_ORDER = PixelOrder::Morton;  // Order rays of a tile are marched and packed
+const bool CPU_DEFERRED_SHADING = true;  // Shade packets and wavefronts after marching, normals batched
+const bool CPU_PACKED_SURFACES = false;  // Half float, octahedral normal surfaces between march and shading
+const bool CPU_SCREEN_NORMALS = false;   // Deferred normals from neighbouring depths, DE taps only at discontinuities
+const float CPU_SCREEN_NORMAL_TOLERANCE = 0.05f;  // Largest depth step to a neighbour, relative to the depth
+const float CPU_SCREEN_NORMAL_BASELINE = 8.0f;    // Shortest difference in epsilons, the depth noise
+
+const bool ALLOC_TRACKING = false;       // Count heap allocations per frame, shown in the HUD
+const int ALLOC_WARMUP_FRAMES = 120;     // Frames before a steady state must stop allocating
+const int ALLOC_SAMPLE_EVERY = 16;       // Every nth allocation records its call stack
+const int ALLOC_SITE_DEPTH = 6;          // Return addresses kept per sampled call stack
+const int ALLOC_SITE_SLOTS = 1024;
+const int ALLOC_REPORT_SITES = 10;
+const int STEADY_CHECK_FRAMES = 120;     // Frames --check-steady-state measures after the warm-up
+const int STEADY_CHECK_WIDTH = 256;      // Small, the check is about allocations, not pixels
+const int STEADY_CHECK_HEIGHT = 192;
+const float STEADY_CHECK_TIMEOUT = 30.0f; // Seconds a frame may take before the renderer counts as stalled
+
+const char* const FLYTHROUGH_FILE = "flythrough.cam";
+const float PLAYBACK_TIMESTEP = 1.0f / 60.0f;  // Simulated time per frame during playback
+
 const Vector3f CAM_INITIAL_POS = Vector3f(0.0f, 0.0f, -3.0f);
 const float CAM_UNIT_SPEED = 1.0f;
 const float CAM_DEGREES_PER_PIXEL = 0.2f;
@@ -22,6 +75,7 @@ const float MAX_BAILOUT = 2.0f;  // Also called "DIVERGENCE"
 const int MAX_ITER = 10;
 const int MIN_ITER = 10;
 const int MAX_STEPS = 20;
+const float STEP_FACTOR = 0.9f;  // Fraction of the distance estimate a march step advances
 const float MAX_DIST = 350.0f;
 const int POWER = 8;
 
@@ -33,4 +87,60 @@ const bool GLOW_ENABLED = true;
 
 const bool HEAT_ENABLED = false;
 
+const bool SHADOWS_ENABLED = false;
+const Vector3f LIGHT_DIRECTION = Vector3f(-0.4f, 0.8f, -0.45f);  // Towards the key light shadows fall from, normalized where used
+const int SHADOW_STEPS = 32;             // March budget of a shadow ray
+const float SHADOW_SOFTNESS = 16.0f;     // Penumbra sharpness, higher is harder
+const float SHADOW_DISTANCE = 1.0f;      // How far shadow rays look, relative to the hit distance
+const float SHADOW_MIN_LIGHT = 0.02f;    // Shadow rays stop once this little light is left
+
+const bool AO_ENABLED = false;
+const int AO_SAMPLES = 5;                // Distance estimates along the normal
+const float AO_RADIUS = 0.05f;           // Of the outermost one, relative to the hit distance
+
+// Estimates a CPU frame may spend on them over all its pixels, shared out to
+// the tiles by their pixel count. Rays still stop at the caps above.
+const int SHADOW_FRAME_BUDGET = 2000000;
+const int AO_FRAME_BUDGET = 1000000;
+
+const int BENCH_POINTS = 4096;              // Points per set in the kernel benchmark
+const int BENCH_SAMPLES = 20;               // Timed samples per kernel and set
+const int BENCH_MIN_SAMPLE_US = 20000;      // Shortest sample, repeats a set until it takes this long
+const float BENCH_SURFACE_DISTANCE = 1e-3f; // How close the near surface points are
+const unsigned int BENCH_SEED = 1;
+const char* const KERNEL_BENCH_FILE = "kernel_bench.json";
+const bool BENCH_PERF_COUNTERS = true;      // Read hardware counters where perf_event_open allows it
+
+const int BENCH_RENDER_WIDTH = 640;
+const int BENCH_RENDER_HEIGHT = 480;
+const int BENCH_RENDER_REPEATS = 3;         // Frames per pose and thread count, the median is reported
+const char* const RENDER_BENCH_FILE = "render_bench.json";
+
+const int ACCURACY_POINTS = 1 << 20;              // Points per set in the accuracy check
+const int ACCURACY_ANCHORS = 4096;                // Surface points the near set is scattered around
+const int ACCURACY_REFERENCE_ITER = MAX_ITER;     // The detail the renderers draw
+const double ACCURACY_REFERENCE_BAILOUT = 1e4;    // Far enough for the estimate to converge
+const float ACCURACY_OVERSHOOT_TOLERANCE = 1e-4f; // Relative, below it an overshoot is rounding
+const float ACCURACY_MAX_UNSAFE = 1e-3f;          // Fraction of a set an estimator may overstep on
+const char* const ACCURACY_FILE = "accuracy.json";
+
+const char* const COST_ATLAS_PREFIX = "cost";
+
+const int SWEEP_WIDTH = 320;                // Full resolution of the parameter sweep
+const int SWEEP_HEIGHT = 240;
+const int SWEEP_REPEATS = 3;                // Frames per pose and setting, the median is timed
+const int SWEEP_MAX_STEPS[] = { 20, 50, 100, 200 };
+const float SWEEP_EPSILON_FACTORS[] = { 1e-3f, 1e-4f, 1e-5f };
+const int SWEEP_MAX_ITER[] = { 6, 10, 14 };
+const float SWEEP_STEP_FACTORS[] = { 0.7f, 0.9f, 1.0f };
+const float SWEEP_RESOLUTIONS[] = { 0.5f, 0.75f, 1.0f };  // Upscaled to full before scoring
+const int SWEEP_REFERENCE_MAX_STEPS = 1000;
+const float SWEEP_REFERENCE_EPSILON_FACTOR = 2e-6f;
+const int SWEEP_REFERENCE_MAX_ITER = 20;
+const float SWEEP_REFERENCE_STEP_FACTOR = 0.5f;
+const float SWEEP_INTERACTIVE_SSIM = 0.8f;  // Least mean SSIM each preset accepts, one ray per
+const float SWEEP_PREVIEW_SSIM = 0.9f;      // pixel aliases the finest detail, so 1 is out of reach
+const float SWEEP_FINAL_SSIM = 0.95f;
+const char* const SWEEP_FILE = "sweep.json";
+
 #endif /* CONSTANTS_H */
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "CostAtlas.h"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+using namespace std;
+
+#include <SFML/System/Clock.hpp>
+
+#include "BenchmarkStats.h"
+#include "CpuMarcher.h"
+#include "RenderBenchmark.h"
+#include "Constants.h"
+
+CostAtlas::CostAtlas()
+	: size(0, 0)
+	, channels()
+{}
+
+const sf::Vector2u& CostAtlas::getSize() const
+{
+	return size;
+}
+
+float CostAtlas::get(const Channel &channel, const int &x, const int &y) const
+{
+	return channels[channel][(size_t)y * size.x + x];
+}
+
+const char* CostAtlas::channelName(const int &channel)
+{
+	static const char* names[ChannelCount] = { "steps", "iterations", "normal_evals", "tile_ms" };
+	return names[channel];
+}
+
+int CostAtlas::exportReferencePoses(const string &prefix)
+{
+	const sf::Vector2u size(BENCH_RENDER_WIDTH, BENCH_RENDER_HEIGHT);
+	const int threads = max(1, (int)thread::hardware_concurrency());
+
+	for (const auto &pose : RenderBenchmark::referencePoses())
+	{
+		CostAtlas atlas;
+		atlas.render(pose.second, size, threads);
+
+		string name = prefix + "_" + pose.first;
+		if (!atlas.save(name))
+		{
+			cout << "Unable to write " << name << "_*.pfm" << endl;
+			return EXIT_FAILURE;
+		}
+
+		cout << pose.first << ": ";
+		atlas.printSummary(cout);
+		cout << endl;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int CostAtlas::summarizeFile(const string &prefix)
+{
+	CostAtlas atlas;
+	if (!atlas.load(prefix))
+	{
+		cout << "Unable to read " << prefix << "_*.pfm" << endl;
+		return EXIT_FAILURE;
+	}
+
+	atlas.printSummary(cout);
+	return EXIT_SUCCESS;
+}
+
+// Tiled like CpuRenderer, so the tile times show what a worker sees
+void CostAtlas::render(const ViewState &view, const sf::Vector2u &size, const int &threads)
+{
+	this->size = size;
+	for (auto &c : channels) c.assign((size_t)size.x * size.y, 0.0f);
+
+	const int tilesX = (size.x + CPU_TILE_SIZE - 1) / CPU_TILE_SIZE;
+	const int tileCount = tilesX * ((size.y + CPU_TILE_SIZE - 1) / CPU_TILE_SIZE);
+	atomic<int> nextTile(0);
+
+	auto work = [&]() {
+		CpuMarcher marcher;
+		marcher.setView(view, size);
+		sf::Uint8 rgba[4];
+		CpuMarcher::RayCost cost;
+
+		for (int index = nextTile++; index < tileCount; index = nextTile++)
+		{
+			int x0 = (index % tilesX) * CPU_TILE_SIZE;
+			int y0 = (index / tilesX) * CPU_TILE_SIZE;
+			int x1 = min(x0 + CPU_TILE_SIZE, (int)size.x);
+			int y1 = min(y0 + CPU_TILE_SIZE, (int)size.y);
+
+			sf::Clock clock;
+			for (int y = y0; y < y1; ++y)
+			{
+				for (int x = x0; x < x1; ++x)
+				{
+					marcher.marchPixel(x, y, rgba, &cost);
+
+					size_t i = (size_t)y * size.x + x;
+					channels[Steps][i] = (float)cost.steps;
+					channels[Iterations][i] = (float)cost.iterations;
+					channels[NormalEvals][i] = (float)cost.normalEvals;
+				}
+			}
+
+			float ms = clock.getElapsedTime().asMicroseconds() / 1000.0f;
+			for (int y = y0; y < y1; ++y)
+			{
+				fill(&channels[TileMs][(size_t)y * size.x + x0], &channels[TileMs][(size_t)y * size.x + x1], ms);
+			}
+		}
+	};
+
+	vector<thread> workers;
+	for (int i = 0; i < max(1, threads); ++i) workers.push_back(thread(work));
+	for (auto &w : workers) w.join();
+}
+
+bool CostAtlas::save(const string &prefix) const
+{
+	for (int c = 0; c < ChannelCount; ++c)
+	{
+		if (!writePfm(prefix + "_" + channelName(c) + ".pfm", size, channels[c])) return false;
+	}
+	return true;
+}
+
+bool CostAtlas::load(const string &prefix)
+{
+	for (int c = 0; c < ChannelCount; ++c)
+	{
+		sf::Vector2u channelSize;
+		if (!readPfm(prefix + "_" + channelName(c) + ".pfm", channelSize, channels[c])) return false;
+		if (c > 0 && channelSize != size) return false;
+		size = channelSize;
+	}
+	return true;
+}
+
+void CostAtlas::printSummary(ostream &out) const
+{
+	enum Class { Sky, Exhausted, Surface, Silhouette, ClassCount };
+	static const char* classNames[ClassCount] = { "sky", "max_steps", "surface", "silhouette" };
+
+	const size_t pixels = (size_t)size.x * size.y;
+	if (pixels == 0) return;
+
+	// Rays that found no surface never evaluate a normal. Rays that ran out
+	// of steps are shaded like hits but never converged.
+	auto hit = [this](const int &x, const int &y) {
+		return get(NormalEvals, x, y) > 0.0f && get(Steps, x, y) < MAX_STEPS;
+	};
+
+	double count[ClassCount] = {};
+	double steps[ClassCount] = {};
+	double iterations[ClassCount] = {};
+	double totalIterations = 0.0, totalSteps = 0.0, normalEvals = 0.0;
+
+	for (int y = 0; y < (int)size.y; ++y)
+	{
+		for (int x = 0; x < (int)size.x; ++x)
+		{
+			int c;
+			if (get(Steps, x, y) >= MAX_STEPS) c = Exhausted;
+			else if (!hit(x, y)) c = Sky;
+			else c = Surface;
+
+			// A hit next to a miss, or the other way round
+			bool h = hit(x, y);
+			if ((x > 0 && hit(x - 1, y) != h) || (x + 1 < (int)size.x && hit(x + 1, y) != h)
+				|| (y > 0 && hit(x, y - 1) != h) || (y + 1 < (int)size.y && hit(x, y + 1) != h))
+			{
+				if (c != Exhausted) c = Silhouette;
+			}
+
+			count[c] += 1.0;
+			steps[c] += get(Steps, x, y);
+			iterations[c] += get(Iterations, x, y);
+			totalIterations += get(Iterations, x, y);
+			totalSteps += get(Steps, x, y);
+			normalEvals += get(NormalEvals, x, y);
+		}
+	}
+
+	out << "cost atlas " << size.x << "x" << size.y << endl;
+	out << left << setw(12) << "class" << right << setw(10) << "pixels" << setw(12) << "steps/px"
+		<< setw(14) << "iterations/px" << setw(16) << "iteration share" << endl;
+	out << fixed;
+	for (int c = 0; c < ClassCount; ++c)
+	{
+		out << left << setw(12) << classNames[c] << right << setprecision(1)
+			<< setw(9) << count[c] * 100.0 / pixels << "%"
+			<< setprecision(2) << setw(12) << (count[c] > 0.0 ? steps[c] / count[c] : 0.0)
+			<< setw(14) << (count[c] > 0.0 ? iterations[c] / count[c] : 0.0)
+			<< setprecision(1) << setw(15) << (totalIterations > 0.0 ? iterations[c] * 100.0 / totalIterations : 0.0) << "%" << endl;
+	}
+
+	double missed = count[Sky] + count[Exhausted];
+	out << "rays without a surface that hit max_steps: " << setprecision(1)
+		<< (missed > 0.0 ? count[Exhausted] * 100.0 / missed : 0.0) << "%" << endl;
+	out << "distance estimates spent on normals: "
+		<< normalEvals * 100.0 / max(totalSteps + normalEvals, 1.0) << "%" << endl;
+
+	// Every pixel of a tile holds the tile's time, take one per tile
+	vector<double> tileMs;
+	for (int y = 0; y < (int)size.y; y += CPU_TILE_SIZE)
+	{
+		for (int x = 0; x < (int)size.x; x += CPU_TILE_SIZE) tileMs.push_back(get(TileMs, x, y));
+	}
+	SampleSummary tiles = summarize(tileMs);
+	out << "tile ms: mean " << setprecision(2) << tiles.mean << ", p99 " << percentile(tileMs, 0.99)
+		<< ", max " << tiles.max << ", total " << tiles.mean * tiles.count << endl;
+}
+
+// Greyscale PFM: rows from the bottom up, little endian floats
+bool CostAtlas::writePfm(const string &filename, const sf::Vector2u &size, const vector<float> &values)
+{
+	ofstream out(filename.c_str(), ios::binary);
+	if (!out) return false;
+
+	out << "Pf\n" << size.x << " " << size.y << "\n-1.0\n";
+	for (int y = (int)size.y - 1; y >= 0; --y)
+	{
+		out.write((const char*)&values[(size_t)y * size.x], size.x * sizeof(float));
+	}
+	return (bool)out;
+}
+
+bool CostAtlas::readPfm(const string &filename, sf::Vector2u &size, vector<float> &values)
+{
+	ifstream in(filename.c_str(), ios::binary);
+	if (!in) return false;
+
+	string magic;
+	float scale;
+	in >> magic >> size.x >> size.y >> scale;
+	in.get();
+	if (magic != "Pf" || scale >= 0.0f || !in) return false;
+
+	values.resize((size_t)size.x * size.y);
+	for (int y = (int)size.y - 1; y >= 0; --y)
+	{
+		in.read((char*)&values[(size_t)y * size.x], size.x * sizeof(float));
+	}
+	return (bool)in;
+}
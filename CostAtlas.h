@@ -0,0 +1,60 @@
+#ifndef COST_ATLAS_H
+#define COST_ATLAS_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+using namespace std;
+
+#include <SFML/System/Vector2.hpp>
+
+#include "ViewState.h"
+
+/*
+ * What every pixel of a CPU march cost, as float channels: march steps,
+ * orbit iterations of all distance estimates, distance estimates spent on
+ * the normal, and the milliseconds of the tile the pixel was marched in.
+ * Saved as one greyscale PFM per channel so any float image viewer opens
+ * them, and summarised into where the budget goes: sky, surface, the
+ * silhouette between them and rays that ran out of MAX_STEPS.
+ */
+class CostAtlas
+{
+public:
+	enum Channel
+	{
+		Steps,
+		Iterations,
+		NormalEvals,
+		TileMs,
+		ChannelCount
+	};
+
+	CostAtlas();
+
+	void render(const ViewState &view, const sf::Vector2u &size, const int &threads);
+
+	// Writes or reads prefix_<channel>.pfm for every channel
+	bool save(const string &prefix) const;
+	bool load(const string &prefix);
+
+	void printSummary(ostream &out) const;
+
+	const sf::Vector2u& getSize() const;
+	float get(const Channel &channel, const int &x, const int &y) const;
+
+	// The command line tools, return the exit code. Renders the reference
+	// poses of RenderBenchmark to prefix_<pose>, or summarises a saved atlas.
+	static int exportReferencePoses(const string &prefix);
+	static int summarizeFile(const string &prefix);
+
+private:
+	sf::Vector2u size;
+	vector<float> channels[ChannelCount];
+
+	static const char* channelName(const int &channel);
+	static bool writePfm(const string &filename, const sf::Vector2u &size, const vector<float> &values);
+	static bool readPfm(const string &filename, sf::Vector2u &size, vector<float> &values);
+};
+
+#endif /* COST_ATLAS_H */
@@ -0,0 +1,967 @@
+#include "CpuMarcher.h"
+
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+using namespace std;
+
+#include "Mandelbulb.h"
+#include "Packing.h"
+#include "Constants.h"
+
+static const float PI = 3.1415926535897932384626433832795f;
+
+static float mix(const float &a, const float &b, const float &f) { return a + (b - a) * f; }
+
+static float clamp01(const float &x) { return max(0.0f, min(1.0f, x)); }
+
+// hsv2rgb from the shader, s and v fixed at 0.8
+static Vector3f trapColor(const float &hue)
+{
+	Vector3f c;
+	float *rgb[3] = { &c.x, &c.y, &c.z };
+	const float k[3] = { 1.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+	for (int i = 0; i < 3; ++i)
+	{
+		float f = hue + k[i];
+		float p = abs((f - floor(f)) * 6.0f - 3.0f);
+		*rgb[i] = 0.8f * mix(1.0f, clamp01(p - 1.0f), 0.8f);
+	}
+	return c;
+}
+
+static float trapHue(const float trap[4])
+{
+	return 2.0f * sqrt(trap[1]*trap[1] + trap[2]*trap[2] + trap[3]*trap[3]);
+}
+
+CpuMarcher::Quality::Quality()
+	: mode(CPU_WAVEFRONT_MARCH ? WavefrontMarch : CPU_PACKET_MARCH ? PacketMarch : ScalarMarch)
+	, maxSteps(MAX_STEPS)
+	, epsilonFactor(EPSILON_FACTOR)
+	, maxIter(MAX_ITER)
+	, stepFactor(STEP_FACTOR)
+	, stepTint(true)
+	, tileOrder(CPU_TILE_ORDER)
+	, pixelOrder(CPU_PIXEL_ORDER)
+	, deferred(CPU_DEFERRED_SHADING)
+	, packedSurfaces(CPU_PACKED_SURFACES)
+	, screenNormals(CPU_SCREEN_NORMALS)
+	, shadowSteps(SHADOW_STEPS)
+	, aoSamples(AO_SAMPLES)
+	, shadowFrameBudget(SHADOW_FRAME_BUDGET)
+	, aoFrameBudget(AO_FRAME_BUDGET)
+{}
+
+CpuMarcher::March::March()
+	: t(0.0f), prevH(0.0f), maxV(0.0f)
+	, steps(0), evals(0), iterations(0)
+	, termination(MaxSteps)
+{}
+
+CpuMarcher::Budget::Budget()
+	: metered(false)
+	, shadow(0.0f), occlusion(0.0f)
+{}
+
+CpuMarcher::CpuMarcher()
+	: view()
+	, quality()
+	, width(1.0f), height(1.0f)
+	, aspect(1.0f)
+	, tanHalfFov(1.0f)
+	, focalDistance(0.0f)
+	, fogDistance(0.0f)
+	, right()
+	, batch()
+	, budget()
+{}
+
+void CpuMarcher::setView(const ViewState &view, const sf::Vector2u &size)
+{
+	this->view = view;
+	width = (float)size.x;
+	height = (float)size.y;
+	aspect = width / height;
+	tanHalfFov = tan(FOV * PI / 360.0f);
+	focalDistance = max(MAX_DIST * EPSILON_LIMIT, MAX_DIST * view.scale);
+	fogDistance = max(FOG_MAX_DIST * EPSILON_LIMIT, FOG_MAX_DIST * view.scale);
+	right = Vector3f::cross(view.cameraUp, view.cameraDirection).normalize();
+	lightDirection = Vector3f::normalize(LIGHT_DIRECTION);
+	budget = Budget();
+}
+
+void CpuMarcher::setQuality(const Quality &quality)
+{
+	this->quality = quality;
+	budget = Budget();
+}
+
+// Estimates each of rays may take now, the cap within what is left of the
+// budget
+int CpuMarcher::allowance(const int &cap, const float &credit, const int &rays) const
+{
+	if (!budget.metered || credit >= (float)cap * rays) return cap;
+	return max(0, (int)(credit / rays));
+}
+
+// primary_ray, x and y are in gl_FragCoord convention
+Vector3f CpuMarcher::primaryRay(const float &x, const float &y) const
+{
+	float px = (2.0f * (x + 0.5f) / width - 1.0f) * tanHalfFov * aspect;
+	float py = (1.0f - 2.0f * (y + 0.5f) / height) * tanHalfFov;
+
+	Vector3f rd = right * px + view.cameraUp * py + view.cameraDirection;
+	return rd.normalize();
+}
+
+// primaryRay for cells of a block, the unnormalised direction is linear
+// in the pixel coordinates
+void CpuMarcher::primaryRays(const int &x0, const int &y0, const int &w, const int *cells, const int &count, Vector3f *rd) const
+{
+	float px = (2.0f * (x0 + 1.0f) / width - 1.0f) * tanHalfFov * aspect;
+	float py = (1.0f - 2.0f * (height - y0) / height) * tanHalfFov;
+	Vector3f dx = right * (2.0f / width * tanHalfFov * aspect);
+	Vector3f dy = view.cameraUp * (2.0f / height * tanHalfFov);
+
+	Vector3f corner = right * px + view.cameraUp * py + view.cameraDirection;
+	for (int i = 0; i < count; ++i)
+	{
+		rd[i] = Vector3f::normalize(corner + dx * (float)(cells[i] % w) + dy * (float)(cells[i] / w));
+	}
+}
+
+void CpuMarcher::RayTrace::step(const float &t, const float &h, const float &eps, const int &iterations)
+{
+	Step s = { t, h, eps, iterations };
+	steps.push_back(s);
+}
+
+void CpuMarcher::RayTrace::tap(const Vector3f &p, const float &h, const int &iterations)
+{
+	Tap s = { p, h, iterations };
+	normalTaps.push_back(s);
+}
+
+// cast_ray, returns the hit distance or -1 when the ray leaves the view.
+// Continues from wherever march stands.
+template <typename Probe>
+float CpuMarcher::castRay(const Vector3f &ro, const Vector3f &rd, March &march, Probe &probe) const
+{
+	March &m = march;
+	while (m.t < focalDistance && ++m.steps < quality.maxSteps)
+	{
+		int before = m.iterations;
+		float h = sdfMandelbulb(ro + rd * m.t, POWER, quality.maxIter, m.trap, m.iterations);
+		++m.evals;
+
+		float eps = max(EPSILON_LIMIT, quality.epsilonFactor * (m.t + 0.5f * m.maxV));
+		probe.step(m.t, h, eps, m.iterations - before);
+		if (h < eps)
+		{
+			m.termination = Hit;
+			break;
+		}
+
+		m.maxV = max((m.prevH + h) / 2.0f, m.maxV);
+		m.prevH = h;
+		m.t += h * quality.stepFactor;
+	}
+
+	return endMarch(m);
+}
+
+float CpuMarcher::endMarch(March &march) const
+{
+	if (march.t < focalDistance) return march.t;
+
+	march.termination = LeftView;
+	return -1.0f;
+}
+
+// Central differences, taps in the order +x, -x, +y, -y, +z, -z
+template <typename Probe>
+Vector3f CpuMarcher::calculateNormal(const Vector3f &p, const float &t, int &iterations, Probe &probe) const
+{
+	float e = max(EPSILON_LIMIT, quality.epsilonFactor * t);
+	const Vector3f offsets[3] = { Vector3f(e, 0.0f, 0.0f), Vector3f(0.0f, e, 0.0f), Vector3f(0.0f, 0.0f, e) };
+
+	float trap[4];
+	float d[6];
+	for (int i = 0; i < 6; ++i)
+	{
+		Vector3f q = (i & 1) ? p - offsets[i / 2] : p + offsets[i / 2];
+		int before = iterations;
+		d[i] = sdfMandelbulb(q, POWER, quality.maxIter, trap, iterations);
+		probe.tap(q, d[i], iterations - before);
+	}
+
+	return Vector3f(d[0] - d[1], d[2] - d[3], d[4] - d[5]).normalize();
+}
+
+// soft_shadow, the light of the key light reaching p. Marching towards the
+// light, the closest approach over the distance travelled is the penumbra.
+// Stops at the first occluder, once almost no light is left or when the
+// steps are spent.
+float CpuMarcher::softShadow(const Vector3f &p, const Vector3f &normal, const float &t, const int &steps, int &evals, int &iterations) const
+{
+	const float eps = max(EPSILON_LIMIT, quality.epsilonFactor * t);
+	const Vector3f from = p + normal * (2.0f * eps);
+	const float far = SHADOW_DISTANCE * t;
+
+	float trap[4];
+	float light = 1.0f;
+	float s = 2.0f * eps;
+	for (int i = 0; i < steps && s < far; ++i)
+	{
+		float h = sdfMandelbulb(from + lightDirection * s, POWER, quality.maxIter, trap, iterations);
+		++evals;
+		if (h < eps) return 0.0f;
+
+		light = min(light, SHADOW_SOFTNESS * h / s);
+		if (light < SHADOW_MIN_LIGHT) break;
+		s += h;
+	}
+	return light;
+}
+
+// ambient_occlusion, taps along the normal out to AO_RADIUS of the hit
+// distance. A tap closer to the surface than it is along the normal is
+// occluded, nearer taps weigh more.
+float CpuMarcher::ambientOcclusion(const Vector3f &p, const Vector3f &normal, const float &t, const int &samples, int &evals, int &iterations) const
+{
+	const float radius = AO_RADIUS * t;
+
+	float trap[4];
+	float occlusion = 0.0f, weight = 1.0f, total = 0.0f;
+	for (int i = 1; i <= samples; ++i)
+	{
+		float r = radius * i / samples;
+		float h = sdfMandelbulb(p + normal * r, POWER, quality.maxIter, trap, iterations);
+		++evals;
+		occlusion += weight * clamp01((r - h) / r);
+		total += weight;
+		weight *= 0.75f;
+	}
+	return total > 0.0f ? 1.0f - occlusion / total : 1.0f;
+}
+
+void CpuMarcher::marchPixel(const int &x, const int &y, sf::Uint8 *rgba, RayCost *cost) const
+{
+	NoProbe probe;
+	Termination termination;
+	float t;
+	Vector3f normal;
+	shadePixel(x, y, rgba, cost, termination, t, normal, probe);
+}
+
+void CpuMarcher::tracePixel(const int &x, const int &y, RayTrace &trace) const
+{
+	trace.x = x;
+	trace.y = y;
+	trace.steps.clear();
+	trace.normalTaps.clear();
+	trace.normal = Vector3f();
+	shadePixel(x, y, trace.rgba, nullptr, trace.termination, trace.t, trace.normal, trace);
+}
+
+// ray_march
+template <typename Probe>
+void CpuMarcher::shadePixel(const int &x, const int &y, sf::Uint8 *rgba, RayCost *cost, Termination &termination, float &t, Vector3f &normal, Probe &probe) const
+{
+	// Rows of the window count up from the bottom in gl_FragCoord
+	Vector3f rd = primaryRay(x + 0.5f, height - y - 0.5f);
+
+	March march;
+	t = castRay(view.cameraPosition, rd, march, probe);
+	termination = march.termination;
+	shade(rd, march, t, rgba, cost, normal, probe);
+}
+
+// The colour of ray_march once the march is done
+template <typename Probe>
+void CpuMarcher::shade(const Vector3f &rd, March &march, const float &t, sf::Uint8 *rgba, RayCost *cost, Vector3f &normal, Probe &probe) const
+{
+	Surface surface;
+	surface.t = t;
+	surface.hue = trapHue(march.trap);
+	surface.maxV = march.maxV;
+	surface.steps = march.steps;
+	surface.shadow = 1.0f;
+	surface.occlusion = 1.0f;
+
+	int normalEvals = 0, shadowEvals = 0, aoEvals = 0;
+	if (t >= 0.0f)
+	{
+		Vector3f p = view.cameraPosition + rd * t;
+		surface.normal = calculateNormal(p, t, march.iterations, probe);
+		normal = surface.normal;
+		normalEvals = 6;
+
+		if (view.shadowToggle)
+		{
+			int steps = allowance(quality.shadowSteps, budget.shadow, 1);
+			surface.shadow = softShadow(p, surface.normal, t, steps, shadowEvals, march.iterations);
+		}
+		if (view.aoToggle)
+		{
+			int samples = allowance(quality.aoSamples, budget.occlusion, 1);
+			surface.occlusion = ambientOcclusion(p, surface.normal, t, samples, aoEvals, march.iterations);
+		}
+		march.evals += normalEvals + shadowEvals + aoEvals;
+
+		if (budget.metered)
+		{
+			budget.shadow -= shadowEvals;
+			budget.occlusion -= aoEvals;
+		}
+	}
+
+	compose(surface, rgba);
+
+	if (cost != nullptr)
+	{
+		cost->steps = march.steps;
+		cost->evals = march.evals;
+		cost->iterations = march.iterations;
+		cost->normalEvals = normalEvals;
+		cost->shadowEvals = shadowEvals;
+		cost->aoEvals = aoEvals;
+		cost->screenNormal = false;
+	}
+}
+
+void CpuMarcher::compose(const Surface &surface, sf::Uint8 *rgba) const
+{
+	Vector3f col;
+	if (surface.t >= 0.0f)
+	{
+		col = trapColor(surface.hue);
+
+		// A headlight casts no visible shadows, shadows come from the key light
+		float diff = view.shadowToggle
+			? max(surface.normal.dot(lightDirection), 0.0f) * surface.shadow
+			: max(-surface.normal.dot(view.cameraDirection), 0.0f);
+		col *= 0.1f + diff;
+		col *= surface.occlusion;
+	}
+
+	// The sky is black, so fog and the tint below act on it too
+	if (view.fogToggle) col *= 1.0f - min(1.0f, surface.t / fogDistance);
+
+	if (view.heatToggle)
+	{
+		float heat = 1.0f - min(1.0f, surface.maxV);
+		col.set(heat, 0.0f, 1.0f - heat);
+	}
+
+	float tint = quality.stepTint ? max(0.1f, (float)surface.steps / quality.maxSteps) : 0.0f;
+	rgba[0] = (sf::Uint8)(clamp01(mix(col.x, 1.0f, tint)) * 255.0f + 0.5f);
+	rgba[1] = (sf::Uint8)(clamp01(mix(col.y, 1.0f, tint)) * 255.0f + 0.5f);
+	rgba[2] = (sf::Uint8)(clamp01(mix(col.z, 1.0f, tint)) * 255.0f + 0.5f);
+	rgba[3] = 255;
+}
+
+// The shading of ray_march as a pass of its own over n marched rays. The
+// normal taps of every hit go through the batched estimator together, the
+// surfaces are stored, packed if asked, and composed from the store.
+void CpuMarcher::shadeDeferred(const Vector3f *rd, March *march, const int &w, const int *cells, const int &n, sf::Uint8 *rgba, RayCost *costs) const
+{
+	const Vector3f &ro = view.cameraPosition;
+	Batch &b = batch;
+
+	int lo = cells[0], hi = cells[0];
+	for (int i = 0; i < n; ++i)
+	{
+		b.t[i] = endMarch(march[i]);
+		lo = min(lo, cells[i]);
+		hi = max(hi, cells[i]);
+	}
+
+	// Where the depths of the neighbours can be looked up
+	if (quality.screenNormals)
+	{
+		if ((int)b.cellSlot.size() < hi - lo + 1) b.cellSlot.resize(hi - lo + 1);
+		fill(b.cellSlot.begin(), b.cellSlot.begin() + (hi - lo + 1), -1);
+		for (int i = 0; i < n; ++i) b.cellSlot[cells[i] - lo] = i;
+	}
+
+	// The taps of calculateNormal, +x, -x, +y, -y, +z, -z, for the hits
+	// the depths could not give a normal
+	int sets = 0;
+	for (int i = 0; i < n; ++i)
+	{
+		b.tapSet[i] = -1;
+
+		float t = b.t[i];
+		if (t < 0.0f) continue;
+		if (quality.screenNormals && screenNormal(rd, w, cells, lo, hi, i, b.normals[i])) continue;
+
+		Vector3f p = ro + rd[i] * t;
+		float e = max(EPSILON_LIMIT, quality.epsilonFactor * t);
+		float *x = &b.tapX[sets * 6], *y = &b.tapY[sets * 6], *z = &b.tapZ[sets * 6];
+		for (int k = 0; k < 6; ++k)
+		{
+			x[k] = p.x; y[k] = p.y; z[k] = p.z;
+			b.tapIterations[sets * 6 + k] = 0;
+		}
+		x[0] += e; x[1] -= e;
+		y[2] += e; y[3] -= e;
+		z[4] += e; z[5] -= e;
+		b.tapSet[i] = sets++;
+	}
+
+	sdfMandelbulbBatch(&b.tapX[0], &b.tapY[0], &b.tapZ[0], sets * 6, POWER, quality.maxIter, &b.tapDist[0], nullptr, &b.tapIterations[0]);
+
+	for (int i = 0; i < n; ++i)
+	{
+		March &m = march[i];
+
+		Surface &surface = b.surfaces[i];
+		surface.t = b.t[i];
+		surface.hue = trapHue(m.trap);
+		surface.maxV = m.maxV;
+		surface.steps = m.steps;
+		surface.shadow = 1.0f;
+		surface.occlusion = 1.0f;
+
+		const int set = b.tapSet[i];
+		if (set >= 0)
+		{
+			const float *d = &b.tapDist[set * 6];
+			surface.normal = Vector3f(d[0] - d[1], d[2] - d[3], d[4] - d[5]).normalize();
+			for (int k = 0; k < 6; ++k) m.iterations += b.tapIterations[set * 6 + k];
+			m.evals += 6;
+		}
+		else if (surface.t >= 0.0f)
+		{
+			surface.normal = b.normals[i];
+		}
+
+		b.shadowEvals[i] = 0;
+		b.aoEvals[i] = 0;
+	}
+
+	if (view.shadowToggle) shadowPass(rd, march, n);
+	if (view.aoToggle) occlusionPass(rd, march, n);
+
+	for (int i = 0; i < n; ++i)
+	{
+		const March &m = march[i];
+		const Surface &surface = b.surfaces[i];
+		if (quality.packedSurfaces) b.packed[i] = pack(surface);
+
+		if (costs != nullptr)
+		{
+			costs[i].steps = m.steps;
+			costs[i].evals = m.evals;
+			costs[i].iterations = m.iterations;
+			costs[i].normalEvals = b.tapSet[i] >= 0 ? 6 : 0;
+			costs[i].shadowEvals = b.shadowEvals[i];
+			costs[i].aoEvals = b.aoEvals[i];
+			costs[i].screenNormal = b.tapSet[i] < 0 && surface.t >= 0.0f;
+		}
+	}
+
+	for (int i = 0; i < n; ++i)
+	{
+		compose(quality.packedSurfaces ? unpack(b.packed[i]) : b.surfaces[i], rgba + i * 4);
+	}
+}
+
+// softShadow for every hit of the batch at once, a step of every shadow
+// ray still marching through the batched estimator at a time
+void CpuMarcher::shadowPass(const Vector3f *rd, March *march, const int &n) const
+{
+	Batch &b = batch;
+	const Vector3f &ro = view.cameraPosition;
+
+	int live = 0;
+	for (int i = 0; i < n; ++i)
+	{
+		const Surface &surface = b.surfaces[i];
+		if (surface.t < 0.0f) continue;
+
+		float eps = max(EPSILON_LIMIT, quality.epsilonFactor * surface.t);
+		b.shadowFrom[i] = ro + rd[i] * surface.t + surface.normal * (2.0f * eps);
+		b.shadowT[i] = 2.0f * eps;
+		b.shadowIds[live++] = i;
+	}
+
+	for (int step = 0; step < quality.shadowSteps && live > 0; ++step)
+	{
+		// Short of budget the rays at the back keep the light they have
+		live = allowance(live, budget.shadow, 1);
+		if (live == 0) break;
+		budget.shadow -= live;
+
+		for (int k = 0; k < live; ++k)
+		{
+			int i = b.shadowIds[k];
+			Vector3f p = b.shadowFrom[i] + lightDirection * b.shadowT[i];
+			b.px[k] = p.x; b.py[k] = p.y; b.pz[k] = p.z;
+			b.iterations[k] = 0;
+		}
+
+		sdfMandelbulbBatch(&b.px[0], &b.py[0], &b.pz[0], live, POWER, quality.maxIter, &b.dist[0], nullptr, &b.iterations[0]);
+
+		// Finished rays are compacted away, the rest keep their order
+		int kept = 0;
+		for (int k = 0; k < live; ++k)
+		{
+			int i = b.shadowIds[k];
+			Surface &surface = b.surfaces[i];
+			float h = b.dist[k];
+			float eps = max(EPSILON_LIMIT, quality.epsilonFactor * surface.t);
+			++b.shadowEvals[i];
+			march[i].iterations += b.iterations[k];
+
+			if (h < eps)
+			{
+				surface.shadow = 0.0f;
+				continue;
+			}
+
+			surface.shadow = min(surface.shadow, SHADOW_SOFTNESS * h / b.shadowT[i]);
+			if (surface.shadow < SHADOW_MIN_LIGHT) continue;
+
+			b.shadowT[i] += h;
+			if (b.shadowT[i] < SHADOW_DISTANCE * surface.t) b.shadowIds[kept++] = i;
+		}
+		live = kept;
+	}
+
+	for (int i = 0; i < n; ++i) march[i].evals += b.shadowEvals[i];
+}
+
+// ambientOcclusion for every hit of the batch, all taps in one batch
+void CpuMarcher::occlusionPass(const Vector3f *rd, March *march, const int &n) const
+{
+	Batch &b = batch;
+	const Vector3f &ro = view.cameraPosition;
+
+	// Fewer taps for every hit once the budget runs short, none leaves
+	// them unoccluded
+	int hits = 0;
+	for (int i = 0; i < n; ++i)
+	{
+		if (b.surfaces[i].t >= 0.0f) ++hits;
+	}
+	const int samples = allowance(quality.aoSamples, budget.occlusion, hits);
+	if (samples == 0) return;
+	budget.occlusion -= (float)hits * samples;
+
+	hits = 0;
+	for (int i = 0; i < n; ++i)
+	{
+		const Surface &surface = b.surfaces[i];
+		if (surface.t < 0.0f) continue;
+
+		Vector3f p = ro + rd[i] * surface.t;
+		float radius = AO_RADIUS * surface.t;
+		for (int k = 0; k < samples; ++k)
+		{
+			Vector3f q = p + surface.normal * (radius * (k + 1) / samples);
+			b.tapX[hits * samples + k] = q.x;
+			b.tapY[hits * samples + k] = q.y;
+			b.tapZ[hits * samples + k] = q.z;
+			b.tapIterations[hits * samples + k] = 0;
+		}
+		++hits;
+	}
+
+	sdfMandelbulbBatch(&b.tapX[0], &b.tapY[0], &b.tapZ[0], hits * samples, POWER, quality.maxIter, &b.tapDist[0], nullptr, &b.tapIterations[0]);
+
+	// Hits come in ray order, so the nth hit seen is the nth set of taps
+	int hit = 0;
+	for (int i = 0; i < n; ++i)
+	{
+		Surface &surface = b.surfaces[i];
+		if (surface.t < 0.0f) continue;
+
+		const float radius = AO_RADIUS * surface.t;
+		float occlusion = 0.0f, weight = 1.0f, total = 0.0f;
+		for (int k = 0; k < samples; ++k)
+		{
+			float r = radius * (k + 1) / samples;
+			occlusion += weight * clamp01((r - b.tapDist[hit * samples + k]) / r);
+			total += weight;
+			weight *= 0.75f;
+			march[i].iterations += b.tapIterations[hit * samples + k];
+		}
+		surface.occlusion = total > 0.0f ? 1.0f - occlusion / total : 1.0f;
+
+		b.aoEvals[i] = samples;
+		march[i].evals += samples;
+		++hit;
+	}
+}
+
+// The depth-aware cross difference of ray i. Along each screen axis the
+// neighbours within CPU_SCREEN_NORMAL_TOLERANCE of the ray's depth are
+// differenced, centrally if both are. Sky, neighbours outside the batch and
+// steeper steps are discontinuities. Depths are only good to an epsilon, so
+// an axis shorter than CPU_SCREEN_NORMAL_BASELINE epsilons is noise. False
+// when an axis is missing or noise.
+bool CpuMarcher::screenNormal(const Vector3f *rd, const int &w, const int *cells, const int &lo, const int &hi, const int &i, Vector3f &normal) const
+{
+	const Batch &b = batch;
+	const Vector3f &ro = view.cameraPosition;
+	const int x = cells[i] % w;
+	const int y = cells[i] / w;
+	const float t = b.t[i];
+	const float baseline = CPU_SCREEN_NORMAL_BASELINE * max(EPSILON_LIMIT, quality.epsilonFactor * t);
+
+	Vector3f axes[2];
+	for (int a = 0; a < 2; ++a)
+	{
+		// The points on either side, the ray's own where there is none
+		Vector3f ends[2] = { ro + rd[i] * t, ro + rd[i] * t };
+		bool found = false;
+		for (int s = 0; s < 2; ++s)
+		{
+			int nx = a == 0 ? x + s * 2 - 1 : x;
+			int ny = a == 1 ? y + s * 2 - 1 : y;
+			if (nx < 0 || nx >= w) continue;
+
+			int cell = ny * w + nx;
+			if (cell < lo || cell > hi) continue;
+
+			int j = b.cellSlot[cell - lo];
+			if (j < 0 || b.t[j] < 0.0f || abs(b.t[j] - t) > CPU_SCREEN_NORMAL_TOLERANCE * t) continue;
+
+			ends[s] = ro + rd[j] * b.t[j];
+			found = true;
+		}
+		if (!found) return false;
+
+		axes[a] = ends[1] - ends[0];
+		if (axes[a].length() < baseline) return false;
+	}
+
+	// Facing the camera whichever way the axes turned out
+	normal = Vector3f::cross(axes[0], axes[1]);
+	float length = normal.length();
+	if (!(length > 0.0f)) return false;
+
+	normal /= length;
+	if (normal.dot(rd[i]) > 0.0f) normal *= -1.0f;
+	return true;
+}
+
+CpuMarcher::PackedSurface CpuMarcher::pack(const Surface &surface)
+{
+	PackedSurface p;
+	p.t = packHalf(surface.t);
+	p.hue = (sf::Uint16)((surface.hue - floor(surface.hue)) * 65535.0f + 0.5f);
+	p.maxV = packHalf(surface.maxV);
+	packNormal(surface.normal, p.normal);
+	p.steps = (sf::Uint16)surface.steps;
+	p.shadow = (sf::Uint8)(clamp01(surface.shadow) * 255.0f + 0.5f);
+	p.occlusion = (sf::Uint8)(clamp01(surface.occlusion) * 255.0f + 0.5f);
+	return p;
+}
+
+CpuMarcher::Surface CpuMarcher::unpack(const PackedSurface &packed)
+{
+	Surface s;
+	s.t = unpackHalf(packed.t);
+	s.hue = packed.hue / 65535.0f;
+	s.maxV = unpackHalf(packed.maxV);
+	s.normal = unpackNormal(packed.normal);
+	s.steps = packed.steps;
+	s.shadow = packed.shadow / 255.0f;
+	s.occlusion = packed.occlusion / 255.0f;
+	return s;
+}
+
+void CpuMarcher::marchPixels(const int &x0, const int &y0, const int &w, const int *cells, const int &count, sf::Uint8 *rgba, RayCost *costs) const
+{
+	// The share of count pixels, a budget of 0 does not meter
+	const float share = count / (width * height);
+	const float unmetered = numeric_limits<float>::infinity();
+	budget.shadow = quality.shadowFrameBudget > 0 ? budget.shadow + quality.shadowFrameBudget * share : unmetered;
+	budget.occlusion = quality.aoFrameBudget > 0 ? budget.occlusion + quality.aoFrameBudget * share : unmetered;
+
+	budget.metered = true;
+	marchBatch(x0, y0, w, cells, count, rgba, costs);
+	budget.metered = false;
+}
+
+void CpuMarcher::marchBatch(const int &x0, const int &y0, const int &w, const int *cells, const int &count, sf::Uint8 *rgba, RayCost *costs) const
+{
+	if (quality.mode == ScalarMarch)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			marchPixel(x0 + cells[i] % w, y0 + cells[i] / w, rgba + i * 4, costs ? costs + i : nullptr);
+		}
+		return;
+	}
+
+	batch.resize(count, max(6, quality.aoSamples));
+	Vector3f *rd = &batch.rd[0];
+	March *march = &batch.march[0];
+
+	primaryRays(x0, y0, w, cells, count, rd);
+	for (int i = 0; i < count; ++i) march[i] = March();
+
+	marchRays(rd, march, count);
+
+	if (quality.deferred)
+	{
+		shadeDeferred(rd, march, w, cells, count, rgba, costs);
+		return;
+	}
+
+	NoProbe probe;
+	for (int i = 0; i < count; ++i)
+	{
+		float t = endMarch(march[i]);
+		Vector3f normal;
+		shade(rd[i], march[i], t, rgba + i * 4, costs ? costs + i : nullptr, normal, probe);
+	}
+}
+
+void CpuMarcher::marchBlock(const int &x0, const int &y0, const int &w, const int &h, sf::Uint8 *rgba, const int &stride, RayCost *costs) const
+{
+	const int n = w * h;
+
+	Batch &b = batch;
+	if (b.cellsW != w || b.cellsH != h || b.cellsCurve != quality.pixelOrder)
+	{
+		PixelOrder::build(quality.pixelOrder, w, h, b.cells);
+		b.cellsW = w;
+		b.cellsH = h;
+		b.cellsCurve = quality.pixelOrder;
+	}
+
+	if ((int)b.rgba.size() < n * 4) b.rgba.resize(n * 4);
+	if ((int)b.costs.size() < n) b.costs.resize(n);
+
+	marchPixels(x0, y0, w, &b.cells[0], n, &b.rgba[0], costs ? &b.costs[0] : nullptr);
+
+	for (int i = 0; i < n; ++i)
+	{
+		size_t j = (size_t)(b.cells[i] / w) * stride + b.cells[i] % w;
+		memcpy(rgba + j * 4, &b.rgba[i * 4], 4);
+		if (costs != nullptr) costs[j] = b.costs[i];
+	}
+}
+
+int CpuMarcher::batchSize() const
+{
+	// Screen space normals only see neighbours within the batch
+	if (quality.mode != ScalarMarch && quality.deferred && quality.screenNormals) return CPU_TILE_SIZE * CPU_TILE_SIZE;
+
+	switch (quality.mode)
+	{
+	case PacketMarch: return CPU_TILE_SIZE * CPU_PACKET_HEIGHT;
+	case WavefrontMarch: return CPU_TILE_SIZE * CPU_TILE_SIZE;
+	default: return CPU_TILE_SIZE;
+	}
+}
+
+const char* CpuMarcher::modeName(const Mode &mode)
+{
+	switch (mode)
+	{
+	case PacketMarch: return "packet";
+	case WavefrontMarch: return "wavefront";
+	default: return "scalar";
+	}
+}
+
+// castRay for n rays by the mode, march is left where each one stopped
+void CpuMarcher::marchRays(const Vector3f *rd, March *march, const int &n) const
+{
+	const int PACKET = CPU_PACKET_WIDTH * CPU_PACKET_HEIGHT;
+
+	if (quality.mode == WavefrontMarch)
+	{
+		marchWavefront(rd, march, n);
+		return;
+	}
+
+	if (quality.mode == PacketMarch)
+	{
+		for (int i = 0; i < n; i += PACKET) marchPacket(rd + i, march + i, min(PACKET, n - i));
+		return;
+	}
+
+	NoProbe probe;
+	for (int i = 0; i < n; ++i) castRay(view.cameraPosition, rd[i], march[i], probe);
+}
+
+// The loop of castRay for all rays of a packet at once, every step sends
+// every lane through the batched estimator and lanes that have finished
+// are masked out of the update. Once too few lanes are left for that to
+// pay off, the rest finish one at a time where they stand.
+void CpuMarcher::marchPacket(const Vector3f *rd, March *march, const int &n) const
+{
+	const int PACKET = CPU_PACKET_WIDTH * CPU_PACKET_HEIGHT;
+	const Vector3f &ro = view.cameraPosition;
+
+	bool active[PACKET];
+	float px[PACKET], py[PACKET], pz[PACKET], dist[PACKET], trap[PACKET * 4];
+	int iterations[PACKET];
+
+	for (int i = 0; i < n; ++i) active[i] = true;
+
+	int live = n;
+	while (live >= n * CPU_PACKET_MIN_ACTIVE && live > 0)
+	{
+		for (int i = 0; i < n; ++i)
+		{
+			March &m = march[i];
+			if (active[i] && !(m.t < focalDistance && ++m.steps < quality.maxSteps))
+			{
+				active[i] = false;
+				--live;
+			}
+
+			Vector3f p = ro + rd[i] * m.t;
+			px[i] = p.x; py[i] = p.y; pz[i] = p.z;
+			iterations[i] = 0;
+		}
+		if (live == 0) break;
+
+		sdfMandelbulbBatch(px, py, pz, n, POWER, quality.maxIter, dist, trap, iterations);
+
+		for (int i = 0; i < n; ++i)
+		{
+			if (!active[i]) continue;
+
+			March &m = march[i];
+			float d = dist[i];
+			m.iterations += iterations[i];
+			++m.evals;
+			memcpy(m.trap, trap + i * 4, 4 * sizeof(float));
+
+			float eps = max(EPSILON_LIMIT, quality.epsilonFactor * (m.t + 0.5f * m.maxV));
+			if (d < eps)
+			{
+				m.termination = Hit;
+				active[i] = false;
+				--live;
+				continue;
+			}
+
+			m.maxV = max((m.prevH + d) / 2.0f, m.maxV);
+			m.prevH = d;
+			m.t += d * quality.stepFactor;
+		}
+	}
+
+	NoProbe probe;
+	for (int i = 0; i < n; ++i)
+	{
+		if (active[i]) castRay(ro, rd[i], march[i], probe);
+	}
+}
+
+CpuMarcher::Batch::Batch()
+	: cellsW(0), cellsH(0)
+	, cellsCurve(PixelOrder::RowMajor)
+{}
+
+void CpuMarcher::Batch::resize(const int &n, const int &taps)
+{
+	if ((int)tapX.size() < n * taps)
+	{
+		tapX.resize(n * taps); tapY.resize(n * taps); tapZ.resize(n * taps); tapDist.resize(n * taps);
+		tapIterations.resize(n * taps);
+	}
+
+	if ((int)march.size() >= n) return;
+
+	rd.resize(n);
+	march.resize(n);
+	ids.resize(n);
+	t.resize(n); dx.resize(n); dy.resize(n); dz.resize(n);
+	px.resize(n); py.resize(n); pz.resize(n); dist.resize(n);
+	trap.resize(n * 4);
+	iterations.resize(n);
+
+	tapSet.resize(n);
+	normals.resize(n);
+	shadowIds.resize(n); shadowEvals.resize(n); aoEvals.resize(n);
+	shadowT.resize(n);
+	shadowFrom.resize(n);
+	surfaces.resize(n);
+	packed.resize(n);
+}
+
+// The loop of castRay for all n rays at once. The rays still marching sit
+// packed at the front of the arrays, each step estimates all of them in
+// one batch and then packs the survivors again, so the SIMD lanes stay
+// full however differently long the rays take. Packing keeps their order,
+// neighbours along the pixel order stay neighbours in the lanes.
+void CpuMarcher::marchWavefront(const Vector3f *rd, March *march, const int &n) const
+{
+	const Vector3f &ro = view.cameraPosition;
+
+	// Sized by marchPixels
+	Batch &f = batch;
+
+	for (int i = 0; i < n; ++i)
+	{
+		f.ids[i] = i;
+		f.t[i] = march[i].t;
+		f.dx[i] = rd[i].x; f.dy[i] = rd[i].y; f.dz[i] = rd[i].z;
+	}
+
+	int live = n;
+	while (live > 0)
+	{
+		// The loop condition, rays out of steps or out of view drop out
+		int k = 0;
+		for (int j = 0; j < live; ++j)
+		{
+			March &m = march[f.ids[j]];
+			if (!(f.t[j] < focalDistance && ++m.steps < quality.maxSteps)) continue;
+
+			f.ids[k] = f.ids[j];
+			f.t[k] = f.t[j];
+			f.dx[k] = f.dx[j]; f.dy[k] = f.dy[j]; f.dz[k] = f.dz[j];
+			f.px[k] = ro.x + f.dx[k] * f.t[k];
+			f.py[k] = ro.y + f.dy[k] * f.t[k];
+			f.pz[k] = ro.z + f.dz[k] * f.t[k];
+			f.iterations[k] = 0;
+			++k;
+		}
+		live = k;
+		if (live == 0) break;
+
+		sdfMandelbulbBatch(&f.px[0], &f.py[0], &f.pz[0], live, POWER, quality.maxIter, &f.dist[0], &f.trap[0], &f.iterations[0]);
+
+		// Hits drop out, the rest step on
+		k = 0;
+		for (int j = 0; j < live; ++j)
+		{
+			March &m = march[f.ids[j]];
+			float d = f.dist[j];
+			m.iterations += f.iterations[j];
+			++m.evals;
+			memcpy(m.trap, &f.trap[j * 4], 4 * sizeof(float));
+
+			float eps = max(EPSILON_LIMIT, quality.epsilonFactor * (m.t + 0.5f * m.maxV));
+			if (d < eps)
+			{
+				m.termination = Hit;
+				continue;
+			}
+
+			m.maxV = max((m.prevH + d) / 2.0f, m.maxV);
+			m.prevH = d;
+			m.t += d * quality.stepFactor;
+
+			f.ids[k] = f.ids[j];
+			f.t[k] = m.t;
+			f.dx[k] = f.dx[j]; f.dy[k] = f.dy[j]; f.dz[k] = f.dz[j];
+			++k;
+		}
+		live = k;
+	}
+}
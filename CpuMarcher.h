@@ -0,0 +1,260 @@
+#ifndef CPU_MARCHER_H
+#define CPU_MARCHER_H
+
+#include <vector>
+using namespace std;
+
+#include <SFML/Config.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include "Vector3f.h"
+#include "ViewState.h"
+#include "PixelOrder.h"
+
+/*
+ * The march of mandelbulb_march.glsl on the CPU, for machines without a
+ * usable GL 4 driver. Marching, lighting, fog and the step count tint all
+ * follow the shader so both backends show the same picture.
+ */
+class CpuMarcher
+{
+public:
+	// What marching one pixel took
+	struct RayCost
+	{
+		int steps;        // As the heat tint counts them
+		int evals;        // Distance estimates, the normal, shadow and occlusion included
+		int iterations;   // Orbit iterations over all of them
+		int normalEvals;
+		int shadowEvals;
+		int aoEvals;
+		bool screenNormal; // Normal from the depths around it, no normalEvals
+	};
+
+	enum Termination
+	{
+		Hit,        // Within epsilon of the surface
+		MaxSteps,   // Shaded where it stopped, like a hit
+		LeftView    // Past the focal distance, sky
+	};
+
+	// The whole march of one pixel, recorded by tracePixel
+	struct RayTrace
+	{
+		struct Step
+		{
+			float t, h, eps;
+			int iterations;
+		};
+
+		struct Tap
+		{
+			Vector3f p;
+			float h;
+			int iterations;
+		};
+
+		int x, y;
+		vector<Step> steps;
+		vector<Tap> normalTaps;   // Empty unless the ray was shaded
+		Termination termination;
+		float t;
+		Vector3f normal;
+		sf::Uint8 rgba[4];
+
+		void step(const float &t, const float &h, const float &eps, const int &iterations);
+		void tap(const Vector3f &p, const float &h, const int &iterations);
+	};
+
+	enum Mode
+	{
+		ScalarMarch,   // One ray at a time
+		PacketMarch,   // CPU_PACKET_WIDTH x CPU_PACKET_HEIGHT rays through the batched estimator
+		WavefrontMarch // Every ray of a block a step at a time, finished rays compacted away
+	};
+
+	// The knobs of the march, the constants unless a tool changes them
+	struct Quality
+	{
+		Mode mode;
+		int maxSteps;
+		float epsilonFactor;
+		int maxIter;
+		float stepFactor;
+		bool stepTint;    // Whiten by steps over maxSteps like the shader
+		PixelOrder::Curve tileOrder;   // How the renderers hand out tiles
+		PixelOrder::Curve pixelOrder;  // How rays of a tile are grouped into packets and wavefronts
+		bool deferred;         // Batched packets and wavefronts shade in a pass of their own
+		bool packedSurfaces;   // That pass keeps its surfaces as half floats and octahedral normals
+		bool screenNormals;    // That pass takes normals from the depths of the batch where it can
+		int shadowSteps;  // Estimates a shadow ray may take, when the view asks for shadows
+		int aoSamples;    // Estimates along the normal, when the view asks for occlusion
+		int shadowFrameBudget;  // Shadow estimates of a whole frame, 0 leaves only shadowSteps
+		int aoFrameBudget;      // Occlusion estimates of a whole frame, 0 leaves only aoSamples
+
+		Quality();
+	};
+
+	CpuMarcher();
+
+	// Takes what the shader gets as uniforms
+	void setView(const ViewState &view, const sf::Vector2u &size);
+	void setQuality(const Quality &quality);
+
+	// Writes the RGBA colour of pixel x, y, rows counted from the top
+	void marchPixel(const int &x, const int &y, sf::Uint8 *rgba, RayCost *cost = nullptr) const;
+
+	// Marches count pixels of the block whose top left is x0, y0 and that is
+	// w wide. cells are y * w + x within the block, rgba and costs receive
+	// the results packed in the same order. Packet and wavefront mode may
+	// differ from marchPixel in the last bits of a distance estimate.
+	// Shadows and occlusion are held to the frame budgets, which marchPixel
+	// and tracePixel leave to the per ray caps.
+	void marchPixels(const int &x0, const int &y0, const int &w, const int *cells, const int &count, sf::Uint8 *rgba, RayCost *costs = nullptr) const;
+
+	// marchPixels over a whole w x h block in quality.pixelOrder, unswizzled
+	// into rows stride pixels apart
+	void marchBlock(const int &x0, const int &y0, const int &w, const int &h, sf::Uint8 *rgba, const int &stride, RayCost *costs = nullptr) const;
+
+	// Pixels per marchPixels call that suit the mode, a tile is split no finer
+	int batchSize() const;
+
+	static const char* modeName(const Mode &mode);
+
+	// The same march, recording every step and normal tap. Marching is
+	// deterministic, so probing pixels again after a frame shows how they
+	// were drawn without slowing the frame down.
+	void tracePixel(const int &x, const int &y, RayTrace &trace) const;
+
+private:
+	ViewState view;
+	Quality quality;
+	float width, height;
+	float aspect;
+	float tanHalfFov;
+	float focalDistance;
+	float fogDistance;
+	Vector3f right;
+	Vector3f lightDirection;
+
+	// Probe policy of marchPixel, compiles to nothing
+	struct NoProbe
+	{
+		void step(const float &, const float &, const float &, const int &) {}
+		void tap(const Vector3f &, const float &, const int &) {}
+	};
+
+	// Where a ray's march stands, castRay picks up from here
+	struct March
+	{
+		float t, prevH, maxV;
+		int steps, evals, iterations;
+		float trap[4];
+		Termination termination;
+
+		March();
+	};
+
+	// What the march leaves for shading one pixel
+	struct Surface
+	{
+		float t;          // -1 for the sky
+		float hue;        // Of the orbit trap colour
+		float maxV;
+		Vector3f normal;
+		int steps;
+		float shadow;     // Of the key light, 1 unless the view asks for shadows
+		float occlusion;  // 1 unless the view asks for it
+	};
+
+	// The same in 14 bytes instead of 36: half floats, the hue's fraction,
+	// which is all trapColor uses, as unorm16, an octahedral normal and
+	// unorm8 light
+	struct PackedSurface
+	{
+		sf::Uint16 t, hue, maxV;
+		sf::Int16 normal[2];
+		sf::Uint16 steps;
+		sf::Uint8 shadow, occlusion;
+	};
+
+	// The rays being marched, in wavefront mode the ones still marching sit
+	// packed at the front of ids to iterations. Kept between calls so a
+	// frame allocates nothing once the first tile has been marched.
+	struct Batch
+	{
+		vector<Vector3f> rd;
+		vector<March> march;
+		vector<int> ids;
+		vector<float> t, dx, dy, dz;
+		vector<float> px, py, pz, dist, trap;
+		vector<int> iterations;
+
+		// Deferred shading, six normal taps per hit that needs them, later
+		// the occlusion taps. tapSet is the ray's set of normal taps or -1,
+		// cellSlot the ray of every cell.
+		vector<float> tapX, tapY, tapZ, tapDist;
+		vector<int> tapIterations, tapSet, cellSlot;
+		vector<Vector3f> normals;
+
+		// Shadow rays still marching sit packed at the front of shadowIds,
+		// they start at shadowFrom and are shadowT along
+		vector<int> shadowIds, shadowEvals, aoEvals;
+		vector<float> shadowT;
+		vector<Vector3f> shadowFrom;
+		vector<Surface> surfaces;
+		vector<PackedSurface> packed;
+
+		// marchBlock's visiting order and its results before unswizzling
+		vector<int> cells;
+		int cellsW, cellsH;
+		PixelOrder::Curve cellsCurve;
+		vector<sf::Uint8> rgba;
+		vector<RayCost> costs;
+
+		Batch();
+		// n rays of up to taps estimates each in the deferred pass
+		void resize(const int &n, const int &taps);
+	};
+	mutable Batch batch;
+
+	// What is left of the frame budgets. Each marchPixels call adds the
+	// share of its pixels, what a batch leaves over, over the sky say, goes
+	// to the next one this marcher takes until setView starts a frame.
+	struct Budget
+	{
+		bool metered;     // Only while marchPixels runs
+		float shadow, occlusion;
+
+		Budget();
+	};
+	mutable Budget budget;
+
+	Vector3f primaryRay(const float &x, const float &y) const;
+	void primaryRays(const int &x0, const int &y0, const int &w, const int *cells, const int &count, Vector3f *rd) const;
+	void marchBatch(const int &x0, const int &y0, const int &w, const int *cells, const int &count, sf::Uint8 *rgba, RayCost *costs) const;
+	int allowance(const int &cap, const float &credit, const int &rays) const;
+	void marchRays(const Vector3f *rd, March *march, const int &n) const;
+	void marchPacket(const Vector3f *rd, March *march, const int &n) const;
+	void marchWavefront(const Vector3f *rd, March *march, const int &n) const;
+	template <typename Probe>
+	void shadePixel(const int &x, const int &y, sf::Uint8 *rgba, RayCost *cost, Termination &termination, float &t, Vector3f &normal, Probe &probe) const;
+	template <typename Probe>
+	void shade(const Vector3f &rd, March &march, const float &t, sf::Uint8 *rgba, RayCost *cost, Vector3f &normal, Probe &probe) const;
+	void shadeDeferred(const Vector3f *rd, March *march, const int &w, const int *cells, const int &n, sf::Uint8 *rgba, RayCost *costs) const;
+	bool screenNormal(const Vector3f *rd, const int &w, const int *cells, const int &lo, const int &hi, const int &i, Vector3f &normal) const;
+	void shadowPass(const Vector3f *rd, March *march, const int &n) const;
+	void occlusionPass(const Vector3f *rd, March *march, const int &n) const;
+	void compose(const Surface &surface, sf::Uint8 *rgba) const;
+	static PackedSurface pack(const Surface &surface);
+	static Surface unpack(const PackedSurface &packed);
+	template <typename Probe>
+	float castRay(const Vector3f &ro, const Vector3f &rd, March &march, Probe &probe) const;
+	float endMarch(March &march) const;
+	template <typename Probe>
+	Vector3f calculateNormal(const Vector3f &p, const float &t, int &iterations, Probe &probe) const;
+	float softShadow(const Vector3f &p, const Vector3f &normal, const float &t, const int &steps, int &evals, int &iterations) const;
+	float ambientOcclusion(const Vector3f &p, const Vector3f &normal, const float &t, const int &samples, int &evals, int &iterations) const;
+};
+
+#endif /* CPU_MARCHER_H */
@@ -0,0 +1,492 @@
+#include "CpuRenderer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+#include "Mandelbulb.h"
+#include "Constants.h"
+
+static const float PI = 3.1415926535897932384626433832795f;
+
+static float pixelsPerRadian(const sf::Vector2u &size)
+{
+	return size.y / (2.0f * tan(FOV * PI / 360.0f));
+}
+
+// Distance to the fractal, conservative where the estimate breaks down
+static float nearestSurface(const Vector3f &p)
+{
+	float d = sdfMandelbulb(p, POWER);
+	return d > EPSILON_LIMIT ? d : EPSILON_LIMIT;
+}
+
+// Camera::scale for a camera distance away from the fractal
+static float scaleAt(const float &distance)
+{
+	static const float initialDistance = sdfMandelbulb(CAM_INITIAL_POS, POWER);
+	return min(initialDistance, distance / initialDistance);
+}
+
+static float turnAngle(const ViewState &from, const ViewState &to)
+{
+	return max((to.cameraDirection - from.cameraDirection).length(), (to.cameraUp - from.cameraUp).length());
+}
+
+// Whether the toggles that change how a pixel is shaded agree
+static bool sameShading(const ViewState &a, const ViewState &b)
+{
+	return a.fogToggle == b.fogToggle && a.heatToggle == b.heatToggle
+		&& a.shadowToggle == b.shadowToggle && a.aoToggle == b.aoToggle;
+}
+
+// Whether a tile marched from one view can stand in for another. Turning
+// shifts every pixel by about the angle turned, moving shifts none by more
+// than the distance moved over the distance to the nearest surface.
+// nearest is nearestSurface of to's camera.
+static bool closeEnough(const ViewState &from, const ViewState &to, const sf::Vector2u &size, const float &nearest)
+{
+	if (!sameShading(from, to)) return false;
+
+	float parallax = (to.cameraPosition - from.cameraPosition).length() / nearest;
+
+	return (turnAngle(from, to) + parallax) * pixelsPerRadian(size) <= CPU_TILE_REUSE_PIXELS;
+}
+
+// Whether the camera is heading for a predicted view: looking the same way,
+// moving at the same velocity, along a line through the prediction. ahead is
+// how far along the line the prediction still is, nearest is nearestSurface
+// of view's camera.
+static bool onTrack(const ViewState &predicted, const ViewState &view, const sf::Vector2u &size, const float &nearest, float &ahead)
+{
+	if (!sameShading(predicted, view)) return false;
+
+	float speed = view.cameraVelocity.length();
+	if (speed == 0.0f || (predicted.cameraVelocity - view.cameraVelocity).length() > speed * 0.01f) return false;
+	if (turnAngle(predicted, view) * pixelsPerRadian(size) > CPU_TILE_REUSE_PIXELS) return false;
+
+	Vector3f line = view.cameraVelocity * (1.0f / speed);
+	Vector3f offset = predicted.cameraPosition - view.cameraPosition;
+	ahead = offset.dot(line);
+	float aside = (offset - line * ahead).length();
+	return aside / nearest * pixelsPerRadian(size) <= CPU_TILE_REUSE_PIXELS;
+}
+
+template <typename T>
+static void smooth(T &average, const float &ms)
+{
+	float smoothed = average;
+	average = smoothed == 0.0f ? ms : smoothed + (ms - smoothed) * CPU_FRAME_TIME_SMOOTHING;
+}
+
+static bool sameView(const ViewState &a, const ViewState &b)
+{
+	return a.cameraPosition.x == b.cameraPosition.x && a.cameraPosition.y == b.cameraPosition.y && a.cameraPosition.z == b.cameraPosition.z
+		&& a.cameraDirection.x == b.cameraDirection.x && a.cameraDirection.y == b.cameraDirection.y && a.cameraDirection.z == b.cameraDirection.z
+		&& a.cameraUp.x == b.cameraUp.x && a.cameraUp.y == b.cameraUp.y && a.cameraUp.z == b.cameraUp.z
+		&& a.scale == b.scale
+		&& sameShading(a, b);
+}
+
+CpuRenderer::CpuRenderer()
+	: workers()
+	, jobMutex()
+	, jobCond()
+	, job()
+	, latest()
+	, pendingTiles()
+	, tileOrder()
+	, nextTile(0)
+	, tilesDone(0)
+	, stopWorkers(false)
+	, running(false)
+	, canvasSize(0, 0)
+	, tiles()
+	, version(0)
+	, cancelledTiles(0)
+	, reusedTiles(0)
+	, supersededFrames(0)
+	, finishedFrames(0)
+	, speculationHits(0)
+	, speculationMisses(0)
+	, frames()
+	, clock()
+	, jobStart(0)
+	, lastRequest(0)
+	, frameTime(0.0f)
+	, speculationTime(0.0f)
+	, textures()
+	, shown(1)
+	, presented(false)
+{}
+
+CpuRenderer::~CpuRenderer()
+{
+	stop();
+}
+
+void CpuRenderer::start(const int &threads)
+{
+	if (running) return;
+
+	int count = threads > 0 ? threads : max(1, (int)thread::hardware_concurrency());
+
+	stopWorkers = false;
+	for (int i = 0; i < count; ++i)
+	{
+		workers.push_back(thread(&CpuRenderer::work, this));
+	}
+	running = true;
+}
+
+void CpuRenderer::stop()
+{
+	if (!running) return;
+
+	{
+		lock_guard<mutex> lock(jobMutex);
+		stopWorkers = true;
+		++version;
+	}
+	jobCond.notify_all();
+
+	for (auto &w : workers) w.join();
+	workers.clear();
+	running = false;
+}
+
+bool CpuRenderer::isRunning() const
+{
+	return running;
+}
+
+int CpuRenderer::getThreadCount() const
+{
+	return (int)workers.size();
+}
+
+void CpuRenderer::request(const ViewState &view, const sf::Vector2u &size)
+{
+	// Every reuse test of this request measures parallax against it, an
+	// estimate not worth holding the workers up for
+	const float nearest = nearestSurface(view.cameraPosition);
+
+	{
+		unique_lock<mutex> lock(jobMutex);
+		if (job.tileCount > 0 && job.size == size && sameView(latest, view)) return;
+		latest = view;
+
+		sf::Int64 now = clock.getElapsedTime().asMicroseconds();
+		float step = view.cameraVelocity.length() * (now - lastRequest) / 1.0e6f;
+		lastRequest = now;
+
+		if (job.speculative && job.size == size)
+		{
+			// Arrived once the camera is at the prediction or passed it since the last request
+			float ahead = 0.0f;
+			bool track = onTrack(job.view, view, size, nearest, ahead);
+			bool arrived = closeEnough(job.view, view, size, nearest) || (track && ahead <= 0.0f && ahead >= -step);
+
+			if (arrived && tilesDone == job.tileCount)
+			{
+				++speculationHits;
+				finishFrame();
+				job.view = view;
+				speculate(nearest);
+				lock.unlock();
+				jobCond.notify_all();
+				return;
+			}
+
+			// Still on the way there, the prerendered frame is kept going
+			if (track && ahead > 0.0f) return;
+
+			// Late, the next prediction leads by what this one would have taken
+			if (arrived)
+			{
+				float ms = (now - jobStart) / 1000.0f;
+				smooth(speculationTime, ms * job.tileCount / max(tilesDone, 1));
+			}
+			++speculationMisses;
+		}
+		else if (tilesDone < job.tileCount)
+		{
+			++supersededFrames;
+		}
+
+		job.view = view;
+		job.size = size;
+		job.version = ++version;
+		job.tilesX = (size.x + CPU_TILE_SIZE - 1) / CPU_TILE_SIZE;
+		job.tileCount = job.tilesX * ((size.y + CPU_TILE_SIZE - 1) / CPU_TILE_SIZE);
+		job.speculative = false;
+
+		if (canvasSize != size)
+		{
+			canvasSize = size;
+			tiles.assign(job.tileCount, Tile());
+			PixelOrder::build(CpuMarcher::Quality().tileOrder, job.tilesX, job.tileCount / job.tilesX, tileOrder);
+		}
+		prepareCanvas();
+
+		// While W/S are held the camera moves on before a frame of this view
+		// could finish, so the workers go straight to where it will be
+		if (CPU_SPECULATE && view.cameraVelocity.length() > 0.0f)
+		{
+			speculate(nearest);
+			lock.unlock();
+			jobCond.notify_all();
+			return;
+		}
+
+		// Only tiles that would visibly move are marched again
+		pendingTiles.clear();
+		tilesDone = 0;
+		for (int i : tileOrder)
+		{
+			if (tiles[i].done && closeEnough(tiles[i].view, view, size, nearest))
+			{
+				reuseTile(i);
+				++tilesDone;
+				++reusedTiles;
+			}
+			else
+			{
+				tiles[i].done = false;
+				pendingTiles.push_back(i);
+			}
+		}
+		nextTile = 0;
+
+		jobStart = clock.getElapsedTime().asMicroseconds();
+		if (tilesDone == job.tileCount) finishFrame();
+	}
+	jobCond.notify_all();
+}
+
+const sf::Texture* CpuRenderer::present()
+{
+	// Upload into the texture that is not on screen, then show it
+	if (frames.consume())
+	{
+		const Frame &frame = frames.getReadBuffer();
+		sf::Texture &texture = textures[shown ^ 1];
+		if (texture.getSize() != frame.size)
+		{
+			texture.create(frame.size.x, frame.size.y);
+			texture.setSmooth(true);
+		}
+		texture.update(&frame.pixels[0]);
+
+		shown ^= 1;
+		presented = true;
+	}
+
+	return presented ? &textures[shown] : nullptr;
+}
+
+float CpuRenderer::getFrameTime() const
+{
+	return frameTime;
+}
+
+int CpuRenderer::getCancelledTiles() const
+{
+	return cancelledTiles;
+}
+
+int CpuRenderer::getReusedTiles() const
+{
+	return reusedTiles;
+}
+
+int CpuRenderer::getSupersededFrames() const
+{
+	return supersededFrames;
+}
+
+int CpuRenderer::getFinishedFrames() const
+{
+	return finishedFrames;
+}
+
+int CpuRenderer::getSpeculationHits() const
+{
+	return speculationHits;
+}
+
+int CpuRenderer::getSpeculationMisses() const
+{
+	return speculationMisses;
+}
+
+void CpuRenderer::work()
+{
+	CpuMarcher marcher;
+	int marcherVersion = -1;
+	Frame tile, rows;
+	tile.pixels.resize(CPU_TILE_SIZE * CPU_TILE_SIZE * 4);
+	rows.pixels.resize(CPU_TILE_SIZE * CPU_TILE_SIZE * 4);
+	vector<int> cells;
+	cells.reserve(CPU_TILE_SIZE * CPU_TILE_SIZE);
+
+	unique_lock<mutex> lock(jobMutex);
+	while (true)
+	{
+		jobCond.wait(lock, [this]{ return stopWorkers || nextTile < (int)pendingTiles.size(); });
+		if (stopWorkers) break;
+
+		FrameJob current = job;
+		int index = pendingTiles[nextTile++];
+		lock.unlock();
+
+		if (marcherVersion != current.version)
+		{
+			marcher.setView(current.view, current.size);
+			marcherVersion = current.version;
+		}
+
+		// Rendered aside, the canvas may be resized for a newer job meanwhile.
+		// The tile is in the order it was marched, back to rows before the
+		// lock is taken.
+		bool finished = renderTile(current, index, marcher, cells, tile);
+		if (finished)
+		{
+			rows.size = tile.size;
+			for (size_t i = 0; i < cells.size(); ++i)
+			{
+				memcpy(&rows.pixels[(size_t)cells[i] * 4], &tile.pixels[i * 4], 4);
+			}
+		}
+
+		lock.lock();
+		if (!finished || current.version != job.version)
+		{
+			if (!finished) ++cancelledTiles;
+			continue;
+		}
+
+		Frame &canvas = frames.getWriteBuffer();
+		int x0 = (index % current.tilesX) * CPU_TILE_SIZE;
+		int y0 = (index / current.tilesX) * CPU_TILE_SIZE;
+		for (unsigned int y = 0; y < rows.size.y; ++y)
+		{
+			memcpy(&canvas.pixels[((size_t)(y0 + y) * current.size.x + x0) * 4], &rows.pixels[(size_t)y * rows.size.x * 4], rows.size.x * 4);
+		}
+		tiles[index].done = true;
+		tiles[index].published = false;
+		tiles[index].view = current.view;
+
+		if (++tilesDone < current.tileCount) continue;
+
+		// A prediction is kept on the canvas until the camera gets there
+		if (current.speculative) smooth(speculationTime, (clock.getElapsedTime().asMicroseconds() - jobStart) / 1000.0f);
+		else finishFrame();
+	}
+}
+
+// Marches one tile into out in the marcher's pixel order, cells is set to
+// that order. Gives up as soon as a newer job is posted.
+bool CpuRenderer::renderTile(const FrameJob &job, const int &index, const CpuMarcher &marcher, vector<int> &cells, Frame &out) const
+{
+	const sf::Vector2u previous = out.size;
+	int x0 = (index % job.tilesX) * CPU_TILE_SIZE;
+	int y0 = (index / job.tilesX) * CPU_TILE_SIZE;
+	out.size.x = min(CPU_TILE_SIZE, (int)job.size.x - x0);
+	out.size.y = min(CPU_TILE_SIZE, (int)job.size.y - y0);
+
+	// Built for the previous tile, only edge tiles differ
+	if (cells.empty() || out.size != previous)
+	{
+		PixelOrder::build(CpuMarcher::Quality().pixelOrder, out.size.x, out.size.y, cells);
+	}
+
+	const int count = (int)cells.size();
+	const int batch = marcher.batchSize();
+	for (int i = 0; i < count; i += batch)
+	{
+		if (version != job.version) return false;
+
+		marcher.marchPixels(x0, y0, out.size.x, &cells[i], min(batch, count - i), &out.pixels[(size_t)i * 4]);
+	}
+
+	return true;
+}
+
+// The write slot sized for the tiles, with the lock held. After a publish
+// it holds an older frame, whatever a job reuses is copied in by reuseTile.
+CpuRenderer::Frame& CpuRenderer::prepareCanvas()
+{
+	Frame &canvas = frames.getWriteBuffer();
+	if (canvas.size != canvasSize)
+	{
+		canvas.size = canvasSize;
+		canvas.pixels.assign((size_t)canvasSize.x * canvasSize.y * 4, 0);
+	}
+	return canvas;
+}
+
+// Copies a finished tile from the frame published last onto the canvas,
+// unless it was marched onto this one. With the lock held.
+void CpuRenderer::reuseTile(const int &index)
+{
+	if (!tiles[index].published) return;
+	tiles[index].published = false;
+
+	const Frame &from = frames.getPublished();
+	Frame &canvas = frames.getWriteBuffer();
+	const int tilesX = (canvasSize.x + CPU_TILE_SIZE - 1) / CPU_TILE_SIZE;
+	const int x0 = (index % tilesX) * CPU_TILE_SIZE;
+	const int y0 = (index / tilesX) * CPU_TILE_SIZE;
+	const int w = min(CPU_TILE_SIZE, (int)canvasSize.x - x0);
+	const int h = min(CPU_TILE_SIZE, (int)canvasSize.y - y0);
+	for (int y = y0; y < y0 + h; ++y)
+	{
+		size_t i = ((size_t)y * canvasSize.x + x0) * 4;
+		memcpy(&canvas.pixels[i], &from.pixels[i], (size_t)w * 4);
+	}
+}
+
+// Hands the canvas to the display by swapping it into the triple buffer,
+// called with the lock held. Every tile now lives in the published frame.
+void CpuRenderer::finishFrame()
+{
+	frames.publish();
+	for (auto &t : tiles) t.published = t.done;
+	prepareCanvas();
+	++finishedFrames;
+
+	smooth(frameTime, (clock.getElapsedTime().asMicroseconds() - jobStart) / 1000.0f);
+}
+
+// Replaces the job with a prediction of where job.view's velocity takes the
+// camera, with the lock held. The lead is how long the last prediction took
+// to render, so the next one is finished about when the camera arrives.
+// nearest is nearestSurface of job.view's camera, the prediction is no
+// closer to the fractal than that less the distance to it. Its scale is
+// taken from that bound, so it is never coarser than the camera's will be.
+void CpuRenderer::speculate(const float &nearest)
+{
+	float lead = speculationTime > 0.0f ? speculationTime : (float)frameTime;
+	Vector3f move = job.view.cameraVelocity * (lead / 1000.0f);
+	job.view.cameraPosition += move;
+	const float predictedNearest = max(EPSILON_LIMIT, nearest - move.length());
+	job.view.scale = min(job.view.scale, scaleAt(predictedNearest));
+	job.version = ++version;
+	job.speculative = true;
+
+	pendingTiles.clear();
+	tilesDone = 0;
+	for (int i : tileOrder)
+	{
+		if (tiles[i].done && closeEnough(tiles[i].view, job.view, job.size, predictedNearest))
+		{
+			reuseTile(i);
+			++tilesDone;
+		}
+		else pendingTiles.push_back(i);
+	}
+	nextTile = 0;
+
+	jobStart = clock.getElapsedTime().asMicroseconds();
+}
@@ -0,0 +1,132 @@
+#ifndef CPU_RENDERER_H
+#define CPU_RENDERER_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+using namespace std;
+
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/System/Clock.hpp>
+
+#include "TripleBuffer.h"
+#include "ViewState.h"
+#include "CpuMarcher.h"
+
+/*
+ * Renders frames with a pool of CpuMarcher threads. Every request for a view
+ * that differs from the current one becomes a new frame job with a higher
+ * version, and only the newest job is ever worked on: workers claim
+ * CPU_TILE_SIZE tiles one at a time along CPU_TILE_ORDER, march their
+ * pixels along CPU_PIXEL_ORDER and abandon a tile between batches once its
+ * version is superseded. Tiles are kept together with the view they were
+ * marched from, a new job reuses those that would move by less than
+ * CPU_TILE_REUSE_PIXELS. Frames are assembled in the write slot of a triple
+ * buffer and handed to the display thread by publishing it, which uploads
+ * them into one of two textures while the other is still being shown.
+ * Reused tiles are copied over from the frame published last.
+ *
+ * While W/S move the camera, a view would be stale before it was finished,
+ * so the workers prerender where the camera will be one frame time later
+ * instead. Requests on the way there leave that job running, the one that
+ * reaches it gets the prerendered frame at once and the next prediction.
+ */
+class CpuRenderer
+{
+public:
+	CpuRenderer();
+	~CpuRenderer();
+
+	// threads of 0 uses every hardware thread
+	void start(const int &threads);
+	void stop();
+	bool isRunning() const;
+	int getThreadCount() const;
+
+	// Latest wins, a view replaces the job in progress unless it is the same
+	void request(const ViewState &view, const sf::Vector2u &size);
+
+	// Display thread, uploads the newest finished frame. Null until the first.
+	const sf::Texture* present();
+
+	// Smoothed ms from a request to its finished frame
+	float getFrameTime() const;
+	int getCancelledTiles() const;
+	int getReusedTiles() const;
+	int getSupersededFrames() const;
+	int getFinishedFrames() const;  // Published for present, speculative ones once the camera arrives
+	int getSpeculationHits() const;
+	int getSpeculationMisses() const;
+
+private:
+	struct Frame
+	{
+		vector<sf::Uint8> pixels;
+		sf::Vector2u size;
+	};
+
+	struct FrameJob
+	{
+		ViewState view;
+		sf::Vector2u size;
+		int version;
+		int tilesX;
+		int tileCount;
+		bool speculative;
+	};
+
+	struct Tile
+	{
+		bool done;
+		bool published;   // Its pixels are in the published frame, not yet on the canvas
+		ViewState view;
+	};
+
+	vector<thread> workers;
+	mutex jobMutex;
+	condition_variable jobCond;
+	FrameJob job;
+	ViewState latest;
+	vector<int> pendingTiles;
+	vector<int> tileOrder;    // Tile indices along CPU_TILE_ORDER
+	int nextTile;
+	int tilesDone;
+	bool stopWorkers;
+	bool running;
+
+	// Finished tiles of recent jobs, only touched with the lock held. The
+	// canvas they are drawn on is the frames' write slot.
+	sf::Vector2u canvasSize;
+	vector<Tile> tiles;
+
+	// Read by workers between rows without taking the lock
+	std::atomic<int> version;
+	std::atomic<int> cancelledTiles;
+	std::atomic<int> reusedTiles;
+	std::atomic<int> supersededFrames;
+	std::atomic<int> finishedFrames;
+	std::atomic<int> speculationHits;
+	std::atomic<int> speculationMisses;
+
+	TripleBuffer<Frame> frames;
+	sf::Clock clock;
+	sf::Int64 jobStart;
+	sf::Int64 lastRequest;
+	std::atomic<float> frameTime;
+	float speculationTime;
+
+	sf::Texture textures[2];
+	int shown;
+	bool presented;
+
+	void work();
+	bool renderTile(const FrameJob &job, const int &index, const CpuMarcher &marcher, vector<int> &cells, Frame &out) const;
+	Frame& prepareCanvas();
+	void reuseTile(const int &index);
+	void finishFrame();
+	void speculate(const float &nearest);
+};
+
+#endif /* CPU_RENDERER_H */
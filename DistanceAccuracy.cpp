@@ -0,0 +1,206 @@
+#include "DistanceAccuracy.h"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+using namespace std;
+
+#include "BenchmarkPoints.h"
+#include "BenchmarkStats.h"
+#include "Mandelbulb.h"
+#include "Constants.h"
+
+DistanceAccuracy::DistanceAccuracy()
+	: sets()
+	, results()
+{}
+
+// sdfMandelbulb in double, with the same angle conventions so it is the same set
+double DistanceAccuracy::reference(const Vector3f &p)
+{
+	const double x0 = p.x, y0 = p.y, z0 = p.z;
+	const double power = POWER;
+
+	double x = x0, y = y0, z = z0;
+	double r = sqrt(x*x + y*y + z*z);
+	double dr = 1.0;
+
+	for (int i = 0; i < ACCURACY_REFERENCE_ITER && r < ACCURACY_REFERENCE_BAILOUT; ++i)
+	{
+		double ph = asin(z / r);
+		double th = atan(y / x);
+		double zr = pow(r, power - 1.0);
+
+		dr = zr * dr * power + 1.0;
+		zr *= r;
+
+		x = zr * cos(power*ph) * cos(power*th) + x0;
+		y = zr * cos(power*ph) * sin(power*th) + y0;
+		z = zr * sin(power*ph) + z0;
+		r = sqrt(x*x + y*y + z*z);
+	}
+
+	return 0.5 * log(r) * r / dr;
+}
+
+int DistanceAccuracy::run(const string &jsonFile)
+{
+	generatePoints();
+
+	cout << left << setw(22) << "variant" << setw(10) << "set" << right
+		 << setw(12) << "mean |err|" << setw(10) << "p1 rel" << setw(10) << "p50 rel" << setw(10) << "p99 rel"
+		 << setw(12) << "max |err|" << setw(11) << "overshoot" << setw(10) << "unsafe" << endl;
+
+	bool marcherSafe = evaluate("sdfMandelbulb", [](const Vector3f &p) { return sdfMandelbulb(p, POWER); });
+	evaluate("sdfMandelbulb_fast", [](const Vector3f &p) { return sdfMandelbulb_fast(p); });
+
+	if (!writeJson(jsonFile))
+	{
+		cout << "Unable to write " << jsonFile << endl;
+		return EXIT_FAILURE;
+	}
+	cout << "Results written to " << jsonFile << endl;
+
+	if (!marcherSafe)
+	{
+		cout << "sdfMandelbulb oversteps on more than " << ACCURACY_MAX_UNSAFE * 100.0f << "% of a set" << endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+void DistanceAccuracy::generatePoints()
+{
+	mt19937 rng(BENCH_SEED);
+
+	// Surface points pushed off in a random direction by 1e-5 to 1e-1,
+	// log uniform, so every scale of the camera logic is covered
+	vector<Vector3f> anchors = surfacePoints(rng, ACCURACY_ANCHORS);
+	uniform_real_distribution<float> exponent(-5.0f, -1.0f);
+	PointSet near = { "near", {}, {} };
+	for (int i = 0; i < ACCURACY_POINTS; ++i)
+	{
+		Vector3f offset = Vector3f::normalize(randomInBall(rng, 1.0f)) * pow(10.0f, exponent(rng));
+		near.points.push_back(anchors[i % anchors.size()] + offset);
+	}
+
+	PointSet around = { "around", {}, {} };
+	while ((int)around.points.size() < ACCURACY_POINTS)
+	{
+		Vector3f p = randomInBall(rng, MAX_BAILOUT);
+		if (reference(p) > 0.0) around.points.push_back(p);
+	}
+
+	PointSet far = { "far", farPoints(rng, ACCURACY_POINTS), {} };
+	PointSet interior = { "interior", interiorPoints(rng, ACCURACY_POINTS), {} };
+
+	sets.push_back(near);
+	sets.push_back(around);
+	sets.push_back(far);
+	sets.push_back(interior);
+
+	for (auto &set : sets)
+	{
+		set.reference.reserve(set.points.size());
+		for (const auto &p : set.points) set.reference.push_back(reference(p));
+	}
+}
+
+// True when the variant is safe to march on every set
+template <typename F>
+bool DistanceAccuracy::evaluate(const string &variant, F f)
+{
+	bool safe = true;
+
+	for (const auto &set : sets)
+	{
+		vector<double> relative;
+		relative.reserve(set.points.size());
+		double sumAbs = 0.0, maxAbs = 0.0;
+		int over = 0, unsafe = 0, counted = 0;
+
+		for (size_t i = 0; i < set.points.size(); ++i)
+		{
+			double ref = set.reference[i];
+			double est = f(set.points[i]);
+			if (!isfinite(ref)) continue;
+
+			// A NaN estimate would stop or derail a march, it counts against the variant
+			++counted;
+			if (!isfinite(est))
+			{
+				++over;
+				++unsafe;
+				continue;
+			}
+
+			double err = est - ref;
+			relative.push_back(err / max(abs(ref), 1e-12));
+			sumAbs += abs(err);
+			maxAbs = max(maxAbs, abs(err));
+
+			if (err > ACCURACY_OVERSHOOT_TOLERANCE * abs(ref)) ++over;
+
+			// Outside, a step of STEP_FACTOR times the estimate must stay short
+			// of the surface. Inside, the estimate must not claim to be outside.
+			if (ref > 0.0 ? est * STEP_FACTOR > ref : est > 0.0) ++unsafe;
+		}
+
+		Result r;
+		r.variant = variant;
+		r.set = set.name;
+		r.meanAbsError = sumAbs / max((int)relative.size(), 1);
+		r.p01 = percentile(relative, 0.01);
+		r.p50 = percentile(relative, 0.5);
+		r.p99 = percentile(relative, 0.99);
+		r.maxAbsError = maxAbs;
+		r.overshoot = (double)over / max(counted, 1);
+		r.unsafe = (double)unsafe / max(counted, 1);
+		results.push_back(r);
+
+		if (r.unsafe > ACCURACY_MAX_UNSAFE) safe = false;
+
+		cout << left << setw(22) << variant << setw(10) << set.name << right << scientific << setprecision(2)
+			 << setw(12) << r.meanAbsError << setw(10) << r.p01 << setw(10) << r.p50 << setw(10) << r.p99
+			 << setw(12) << r.maxAbsError << fixed << setprecision(4)
+			 << setw(11) << r.overshoot << setw(10) << r.unsafe << endl;
+	}
+
+	cout << variant << (safe ? " is" : " is not") << " safe to march" << endl;
+	return safe;
+}
+
+bool DistanceAccuracy::writeJson(const string &filename) const
+{
+	ofstream out(filename.c_str());
+	if (!out) return false;
+
+	out << "{\n"
+		<< "  \"benchmark\": \"accuracy\",\n"
+		<< "  \"points\": " << ACCURACY_POINTS << ",\n"
+		<< "  \"reference_iterations\": " << ACCURACY_REFERENCE_ITER << ",\n"
+		<< "  \"step_factor\": " << STEP_FACTOR << ",\n"
+		<< "  \"results\": [\n";
+
+	out << setprecision(6);
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const Result &r = results[i];
+		out << "    { \"variant\": \"" << r.variant << "\", \"set\": \"" << r.set << "\""
+			<< ", \"mean_abs_error\": " << r.meanAbsError
+			<< ", \"p01_relative_error\": " << r.p01
+			<< ", \"p50_relative_error\": " << r.p50
+			<< ", \"p99_relative_error\": " << r.p99
+			<< ", \"max_abs_error\": " << r.maxAbsError
+			<< ", \"overshoot_fraction\": " << r.overshoot
+			<< ", \"unsafe_fraction\": " << r.unsafe
+			<< " }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+
+	out << "  ]\n}\n";
+	return (bool)out;
+}
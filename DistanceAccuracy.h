@@ -0,0 +1,62 @@
+#ifndef DISTANCE_ACCURACY_H
+#define DISTANCE_ACCURACY_H
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "Vector3f.h"
+
+/*
+ * Compares the distance estimators with a double precision reference: the
+ * trigonometric estimate iterated ACCURACY_REFERENCE_ITER times with a far
+ * bailout. Over ACCURACY_POINTS points near the surface, in the space around
+ * it, far away and inside it reports the distribution of the relative error,
+ * how often an estimate overshoots the reference and how often it overshoots
+ * by more than a STEP_FACTOR march step absorbs, which can step through the
+ * surface.
+ */
+class DistanceAccuracy
+{
+public:
+	DistanceAccuracy();
+
+	// Prints a table and writes the results as JSON. Fails when the estimator
+	// the marchers use is unsafe.
+	int run(const string &jsonFile);
+
+	static double reference(const Vector3f &p);
+
+private:
+	struct PointSet
+	{
+		string name;
+		vector<Vector3f> points;
+		vector<double> reference;
+	};
+
+	struct Result
+	{
+		string variant;
+		string set;
+		double meanAbsError;
+		double p01;          // Percentiles of the relative error
+		double p50;
+		double p99;
+		double maxAbsError;
+		double overshoot;    // Fraction over the reference
+		double unsafe;       // Fraction a march step would cross the surface at
+	};
+
+	vector<PointSet> sets;
+	vector<Result> results;
+
+	void generatePoints();
+
+	template <typename F>
+	bool evaluate(const string &variant, F f);
+
+	bool writeJson(const string &filename) const;
+};
+
+#endif /* DISTANCE_ACCURACY_H */
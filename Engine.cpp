@@ -4,6 +4,7 @@
 /* Standard Libary */
 #include <string>
 #include <iostream>
+#include <algorithm>
 using namespace std;
 
 /* SFML */
@@ -17,11 +18,20 @@ Engine::Engine(const string& title, const int &width, const int &height, const i
 	, deltaTime(1.0f / (float)max_fps) // assume initial dt is at 60fps
 	, mouseX(0) , mouseY(0)
 	, clock()
+	, stats(FRAME_STATS_HISTORY)
 	, listeners(new vector<InputListener*>())
 	, heldKeys(new unordered_set<sf::Keyboard::Key>())
 	, title(sf::String(title.c_str()))
 	, settings()
 	, isFullscreen(IS_FULLSCREEN)
+	, threaded(THREADED_UPDATE)
+	, running(false)
+	, rendering(false)
+	, renderThread()
+	, lateLatch(LATE_LATCH_INPUT)
+	, pendingMouse(0, 0)
+	, lookStamped(false)
+	, latency(FRAME_STATS_HISTORY)
 {
 	settings.depthBits = 24;
 	settings.stencilBits = 8;
@@ -38,6 +48,7 @@ Engine::Engine(const string& title, const int &width, const int &height, const i
 
 Engine::~Engine()
 {
+	stopRenderThread();
 	if (window != nullptr) delete window;
 	if (listeners != nullptr) delete listeners;
 	if (heldKeys != nullptr) delete heldKeys;
@@ -54,53 +65,190 @@ int Engine::run()
 	clock.restart();
 
 	centerMouse();
-	while (window->isOpen())
+	running = true;
+
+	if (threaded) runThreaded();
+	else runSerial();
+
+	if (window->isOpen()) window->close();
+	return EXIT_SUCCESS;
+}
+
+void Engine::runSerial()
+{
+	while (running)
     {
-		preupdate();
+		simulate(deltaTime);
+		renderFrame();
 
-		sf::Event event;
-		while (window->pollEvent(event))
-		{
-			if (event.type == sf::Event::Closed) window->close();
+		deltaTime = clock.restart().asSeconds();
+		cur_fps = 1.0f / deltaTime;
+		stats.addFrame(deltaTime);
+    }
+}
+
+void Engine::runThreaded()
+{
+	const sf::Time tick = sf::seconds(1.0f / UPDATE_TICK_RATE);
+	const sf::Time sample = sf::seconds(1.0f / LATE_LATCH_SAMPLE_RATE);
+	deltaTime = tick.asSeconds();
 
-			if (event.type == sf::Event::GainedFocus) {
-				window->setMouseCursorGrabbed(true);
-				window->setMouseCursorVisible(false);
-			}
+	// Publish a first state before anything is drawn
+	simulate(deltaTime);
+	startRenderThread();
 
-			if (event.type == sf::Event::LostFocus) {
-				window->setMouseCursorGrabbed(false);
-				window->setMouseCursorVisible(true);
-			}
+	sf::Clock tickClock;
+	sf::Time nextTick = tick;
+	while (running)
+	{
+		simulate(deltaTime);
 
-			// Check for input events when a window has focus
-			if (window->hasFocus()) checkInput(event);
+		// Fixed tick rate, if the simulation falls behind it does not try to
+		// catch up. Late latched, the cursor is read while waiting for it.
+		sf::Time now = tickClock.getElapsedTime();
+		if (nextTick < now) nextTick = now;
+		while (now < nextTick)
+		{
+			sf::sleep(lateLatch ? min(nextTick - now, sample) : nextTick - now);
+			if (lateLatch) sampleMouse();
+			now = tickClock.getElapsedTime();
 		}
+		nextTick += tick;
+	}
+
+	stopRenderThread();
+}
 
-		if (window->hasFocus()) centerMouse();  // THIS MUST BE OUTSIDE THE EVENT POLLING LOOP
+void Engine::simulate(const float dt)
+{
+	preupdate();
+	pollInput();
 
-		if (!heldKeys->empty())
+	if (!heldKeys->empty())
+	{
+		for (const auto& k : *heldKeys)
 		{
-			for (const auto& k : *heldKeys)
-			{
-				notifyKeyHeld(k, deltaTime);
-			}
+			notifyKeyHeld(k, dt);
 		}
+	}
 
-		updateInputListeners(deltaTime);
-		update(deltaTime);
+	updateInputListeners(dt);
+	update(dt);
+	latency.statePublished();
+}
 
-		window->clear(sf::Color::Black);
-		draw();
-		window->display();
+// Returns true when any input reached the listeners
+bool Engine::pollInput()
+{
+	bool input = false;
 
-		deltaTime = clock.restart().asSeconds();
-		cur_fps = 1.0f / deltaTime;
+	sf::Event event;
+	while (window->pollEvent(event))
+	{
+		if (event.type == sf::Event::Closed) stop();
 
-		
-    }
+		if (event.type == sf::Event::GainedFocus) {
+			window->setMouseCursorGrabbed(true);
+			window->setMouseCursorVisible(false);
+		}
 
-	return EXIT_SUCCESS;
+		if (event.type == sf::Event::LostFocus) {
+			window->setMouseCursorGrabbed(false);
+			window->setMouseCursorVisible(true);
+		}
+
+		// Check for input events when a window has focus
+		if (window->hasFocus()) input |= checkInput(event);
+	}
+
+	if (window->hasFocus()) centerMouse();  // THIS MUST BE OUTSIDE THE EVENT POLLING LOOP
+	lookStamped = false;
+
+	return input;
+}
+
+// Events that arrived while the frame was simulated, only the render thread
+// of a serial loop may poll them. Held keys are left for the next update().
+void Engine::latchInput()
+{
+	if (!lateLatch || renderThread.joinable()) return;
+
+	if (pollInput() && latch) latch();
+	latency.statePublished();
+}
+
+void Engine::renderFrame()
+{
+	latchInput();
+
+	// Threaded, a state published while drawing is credited to the next frame,
+	// which errs on the side of reporting more latency
+	int published = latency.beginFrame();
+
+	window->clear(sf::Color::Black);
+	draw();
+	window->display();
+
+	latency.framePresented(published);
+}
+
+void Engine::renderLoop()
+{
+	window->setActive(true);
+
+	sf::Clock frameClock;
+	while (rendering)
+	{
+		renderFrame();
+
+		float dt = frameClock.restart().asSeconds();
+		cur_fps = 1.0f / dt;
+		stats.addFrame(dt);
+	}
+
+	window->setActive(false);
+}
+
+void Engine::startRenderThread()
+{
+	// The context follows the render thread, it can only be active on one thread
+	window->setActive(false);
+	rendering = true;
+	renderThread = std::thread(&Engine::renderLoop, this);
+}
+
+void Engine::stopRenderThread()
+{
+	if (!renderThread.joinable()) return;
+
+	rendering = false;
+	renderThread.join();
+	window->setActive(true);
+}
+
+void Engine::stop()
+{
+	running = false;
+}
+
+void Engine::setThreadedUpdate(const bool &threaded)
+{
+	this->threaded = threaded;
+}
+
+bool Engine::isThreadedUpdate() const
+{
+	return threaded;
+}
+
+void Engine::setLateLatch(const bool &lateLatch)
+{
+	this->lateLatch = lateLatch;
+}
+
+bool Engine::isLateLatch() const
+{
+	return lateLatch;
 }
 
 sf::RenderWindow* Engine::getWindow()
@@ -134,6 +282,11 @@ void Engine::setDrawFunc  (std::function<void(void)> f)
 	this->draw = f;
 }
 
+void Engine::setLatchFunc (std::function<void(void)> f)
+{
+	this->latch = f;
+}
+
 
 void Engine::registerInputListener(InputListener *listener)
 {
@@ -263,14 +416,40 @@ void Engine::wrapMouse()
 	mouseY = mousePos.y;
 }
 
-void Engine::checkInput(const sf::Event &event)
+// Event thread, between ticks. The cursor is recentred after every poll and
+// the state that absorbed the look has been published by then, so its
+// offset is all the mouse look still pending.
+void Engine::sampleMouse()
+{
+	sf::Vector2i delta(0, 0);
+	if (window->hasFocus()) delta = sf::Mouse::getPosition(*window) - sf::Vector2i(window->getSize()) / 2;
+
+	{
+		lock_guard<mutex> lock(mouseMutex);
+		pendingMouse = delta;
+	}
+
+	// The next frame draws it, so it counts as published from here
+	if (!lookStamped && (delta.x != 0 || delta.y != 0))
+	{
+		latency.inputSampled();
+		latency.statePublished();
+		lookStamped = true;
+	}
+}
+
+bool Engine::checkInput(const sf::Event &event)
 {
 	switch (event.type)
 	{
 	case sf::Event::KeyPressed:
-		if (event.key.code == sf::Keyboard::Escape) window->close();
+		if (event.key.code == sf::Keyboard::Escape) stop();
 		if (event.key.code == sf::Keyboard::F) {
+			// The render thread owns the context, it has to let go while the window is recreated
+			bool wasRendering = renderThread.joinable();
+			stopRenderThread();
 			isFullscreen = !isFullscreen; openWindow();
+			if (wasRendering) startRenderThread();
 		}
 		notifyKeyPressed(event.key.code, deltaTime);
 		heldKeys->insert(event.key.code);
@@ -282,7 +461,10 @@ void Engine::checkInput(const sf::Event &event)
 		break;
 
 	case sf::Event::MouseMoved:
+		// Recentring the cursor posts a move that carries no input
+		if (event.mouseMove.x == mouseX && event.mouseMove.y == mouseY) return false;
 		notifyMouseMoved(event.mouseMove, deltaTime);
+		if (lookStamped) return true;
 		break;
 
 	case sf::Event::MouseButtonPressed:
@@ -298,11 +480,24 @@ void Engine::checkInput(const sf::Event &event)
 		break;
 
 	default:
-		break;
+		return false;
 	}
+
+	latency.inputSampled();
+	return true;
 }
 
 float Engine::getFPS()
 {
 	return cur_fps;
+}
+
+FrameStats& Engine::getFrameStats()
+{
+	return stats;
+}
+
+const LatencyTracker& Engine::getLatencyTracker() const
+{
+	return latency;
 }
\ No newline at end of file
@@ -5,6 +5,9 @@
 #include <functional>
 #include <unordered_set>
 #include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
 using namespace std;
 
 /* SFML */
@@ -13,6 +16,8 @@ using namespace std;
 #include <SFML/Window/Keyboard.hpp>
 
 #include "InputListener.h"
+#include "FrameStats.h"
+#include "LatencyTracker.h"
 
 
 class Engine
@@ -22,6 +27,28 @@ public:
 	~Engine();
 
 	int run();
+	void stop();
+
+	// When threaded, input and update() run at UPDATE_TICK_RATE on the calling
+	// thread while draw() runs as fast as it can on a render thread. update() and
+	// draw() must then only share state through thread safe hand-offs.
+	void setThreadedUpdate(const bool &threaded);
+	bool isThreadedUpdate() const;
+
+	// Polls input once more right before draw() and hands it to the latch
+	// function, so the frame shows mouse look read after update(). When
+	// threaded, draw() can only predict it from the look consumeWithLook()
+	// returns, which the event thread keeps up to date between ticks.
+	void setLateLatch(const bool &lateLatch);
+	bool isLateLatch() const;
+
+	// The state update() publishes and the mouse look it has not absorbed
+	// yet must change together, or a frame drawn in between shows the look
+	// twice or not at all. publish hands the state over and the pending look
+	// is cleared under the same lock, consume takes the newest state and
+	// returns the look still pending on top of it.
+	template <typename F> void publishWithLook(F publish);
+	template <typename F> sf::Vector2i consumeWithLook(F consume) const;
 
 	sf::RenderWindow* getWindow();
 	sf::Clock& getClock();
@@ -30,10 +57,13 @@ public:
 	void setPreupdateFunc(std::function<void(void)> f);
 	void setUpdateFunc(std::function<void(const float)> f);
 	void setDrawFunc  (std::function<void(void)> f);
+	void setLatchFunc (std::function<void(void)> f);
 
 	void registerInputListener(InputListener *listener);
 
 	float getFPS();
+	FrameStats& getFrameStats();
+	const LatencyTracker& getLatencyTracker() const;
 
 private:
 	int max_fps;
@@ -44,8 +74,22 @@ private:
 	sf::ContextSettings settings;
 	bool isFullscreen;
 
+	bool threaded;
+	std::atomic<bool> running;
+	std::atomic<bool> rendering;
+	std::thread renderThread;
+	std::atomic<bool> lateLatch;
+
+	// Mouse look since the simulation last polled, written by the event
+	// thread only and cleared once the state that absorbed it is published
+	mutable std::mutex mouseMutex;
+	sf::Vector2i pendingMouse;
+	bool lookStamped;  // Latency of the pending look stamped when first seen, not again by its move events
+
 	sf::RenderWindow *window;
 	sf::Clock clock;
+	FrameStats stats;
+	LatencyTracker latency;
 
 	std::vector<InputListener*> *listeners;
 	std::unordered_set<sf::Keyboard::Key> *heldKeys;
@@ -54,8 +98,19 @@ private:
 	std::function<void(void)> preupdate;
 	std::function<void(const float)> update;
 	std::function<void(void)> draw;
+	std::function<void(void)> latch;
 
 
+	void runSerial();
+	void runThreaded();
+	void simulate(const float dt);
+	bool pollInput();
+	void latchInput();
+	void renderFrame();
+	void renderLoop();
+	void startRenderThread();
+	void stopRenderThread();
+
 	void updateInputListeners(const float dt) const;
 
 	void notifyKeyPressed(const sf::Keyboard::Key &key, const float dt) const;
@@ -73,12 +128,29 @@ private:
 
 	void centerMouse();
 	void wrapMouse();
+	void sampleMouse();
 
-	void checkInput(const sf::Event &e);
+	bool checkInput(const sf::Event &e);
 
 	/** OpenGL Helpers **/
 	void initGL();
 	void perspectiveGL( double fovY, double aspect, double zNear, double zFar );
 };
 
+template <typename F>
+void Engine::publishWithLook(F publish)
+{
+	lock_guard<mutex> lock(mouseMutex);
+	publish();
+	pendingMouse = sf::Vector2i(0, 0);
+}
+
+template <typename F>
+sf::Vector2i Engine::consumeWithLook(F consume) const
+{
+	lock_guard<mutex> lock(mouseMutex);
+	consume();
+	return pendingMouse;
+}
+
 #endif /* ENGINE_H */
\ No newline at end of file
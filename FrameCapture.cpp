@@ -0,0 +1,248 @@
+#include "FrameCapture.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+using namespace std;
+
+#include "Constants.h"
+
+FrameCapture::FrameCapture()
+	: supported(false)
+	, recording(false)
+	, width(0), height(0)
+	, session(0)
+	, frame(0)
+	, next(0)
+	, dropped(0)
+	, written(0)
+	, slots()
+	, encoder()
+	, queueMutex()
+	, queueCond()
+	, queue()
+	, freeFrames()
+	, stopEncoder(false)
+{}
+
+FrameCapture::~FrameCapture()
+{
+	if (recording) stop();
+
+	if (supported)
+	{
+		for (auto& s : slots) glext::glDeleteBuffers(1, &s.pbo);
+	}
+}
+
+bool FrameCapture::init()
+{
+	glext::load();
+	supported = glext::hasPixelBuffers();
+	if (!supported) return false;
+
+	slots.resize(CAPTURE_PBO_COUNT);
+	for (auto& s : slots)
+	{
+		glext::glGenBuffers(1, &s.pbo);
+		s.fence = nullptr;
+		s.frame = 0;
+	}
+
+	return true;
+}
+
+bool FrameCapture::start(const int &width, const int &height)
+{
+	if (!supported || recording) return false;
+
+	this->width = width;
+	this->height = height;
+
+	const size_t frameBytes = (size_t)width * height * 4;
+	for (auto& s : slots)
+	{
+		glext::glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+		glext::glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, nullptr, GL_STREAM_READ);
+	}
+	glext::glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	// Every buffer the encoder will ever see is allocated up front
+	for (int i = 0; i < CAPTURE_QUEUE_DEPTH; ++i)
+	{
+		EncodedFrame *f = new EncodedFrame();
+		f->pixels.resize(frameBytes);
+		freeFrames.push_back(f);
+	}
+
+	++session;
+	frame = 0;
+	next = 0;
+	dropped = 0;
+	written = 0;
+	stopEncoder = false;
+	encoder = thread(&FrameCapture::encode, this);
+	recording = true;
+
+	cout << "Recording capture session " << session << " at " << width << "x" << height << endl;
+	return true;
+}
+
+void FrameCapture::stop()
+{
+	if (!recording) return;
+
+	collect(true);
+	recording = false;
+
+	{
+		lock_guard<mutex> lock(queueMutex);
+		stopEncoder = true;
+	}
+	queueCond.notify_one();
+	encoder.join();
+
+	for (auto f : freeFrames) delete f;
+	freeFrames.clear();
+
+	cout << "Capture session " << session << " finished: "
+		 << written << " frames written, " << dropped << " dropped" << endl;
+}
+
+bool FrameCapture::isRecording() const
+{
+	return recording;
+}
+
+unsigned int FrameCapture::getWidth() const
+{
+	return (unsigned int)width;
+}
+
+unsigned int FrameCapture::getHeight() const
+{
+	return (unsigned int)height;
+}
+
+void FrameCapture::captureFrame()
+{
+	if (!recording) return;
+
+	collect(false);
+
+	// Every PBO is still waiting on the GPU, drop rather than stall
+	Slot &s = slots[next];
+	if (s.fence != nullptr)
+	{
+		++dropped;
+		++frame;
+		return;
+	}
+
+	glext::glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+	glReadPixels(0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, 0);
+	glext::glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	s.fence = glext::glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	s.frame = frame++;
+	next = (next + 1) % slots.size();
+}
+
+void FrameCapture::collect(const bool &wait)
+{
+	const GLbitfield flushBit = 0x00000001; // GL_SYNC_FLUSH_COMMANDS_BIT
+	const GLuint64_t timeout = wait ? 1000000000ull : 0ull;
+
+	// Oldest slot first so frames reach the encoder in order
+	for (size_t i = 0; i < slots.size(); ++i)
+	{
+		Slot &s = slots[(next + i) % slots.size()];
+		if (s.fence == nullptr) continue;
+
+		GLenum status = glext::glClientWaitSync(s.fence, wait ? flushBit : 0, timeout);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			if (!wait) break;
+		}
+
+		glext::glDeleteSync(s.fence);
+		s.fence = nullptr;
+
+		EncodedFrame *f = nullptr;
+		{
+			lock_guard<mutex> lock(queueMutex);
+			if (!freeFrames.empty())
+			{
+				f = freeFrames.back();
+				freeFrames.pop_back();
+			}
+		}
+
+		if (f == nullptr)
+		{
+			++dropped;
+			continue;
+		}
+
+		glext::glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+		void *data = glext::glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, f->pixels.size(), GL_MAP_READ_BIT);
+		if (data != nullptr)
+		{
+			memcpy(&f->pixels[0], data, f->pixels.size());
+			glext::glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glext::glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		f->frame = s.frame;
+		{
+			lock_guard<mutex> lock(queueMutex);
+			if (data != nullptr) queue.push_back(f);
+			else freeFrames.push_back(f);
+		}
+		queueCond.notify_one();
+	}
+}
+
+void FrameCapture::encode()
+{
+	unique_lock<mutex> lock(queueMutex);
+	while (true)
+	{
+		queueCond.wait(lock, [this]{ return stopEncoder || !queue.empty(); });
+		if (queue.empty()) break;
+
+		EncodedFrame *f = queue.front();
+		queue.pop_front();
+
+		lock.unlock();
+		writeFrame(*f);
+		lock.lock();
+
+		freeFrames.push_back(f);
+		++written;
+	}
+}
+
+void FrameCapture::writeFrame(const EncodedFrame &f) const
+{
+	char filename[64];
+	sprintf(filename, "capture_%03d_%05d.ppm", session, f.frame);
+
+	ofstream out(filename, ios::binary);
+	out << "P6\n" << width << " " << height << "\n255\n";
+
+	// GL rows start at the bottom and are BGRA, PPM wants top-down RGB
+	vector<unsigned char> row(width * 3);
+	for (int y = height - 1; y >= 0; --y)
+	{
+		const unsigned char *src = &f.pixels[(size_t)y * width * 4];
+		for (int x = 0; x < width; ++x)
+		{
+			row[x*3 + 0] = src[x*4 + 2];
+			row[x*3 + 1] = src[x*4 + 1];
+			row[x*3 + 2] = src[x*4 + 0];
+		}
+		out.write((const char*)&row[0], row.size());
+	}
+}
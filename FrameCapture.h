@@ -0,0 +1,77 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+using namespace std;
+
+#include "GLFunctions.h"
+
+/*
+ * Records the framebuffer to a numbered PPM sequence without stalling the GL
+ * pipeline. glReadPixels targets a ring of pixel buffer objects, so frame N is
+ * copied out of its PBO only once its fence has signalled, while later frames
+ * keep rendering. Mapped pixels are handed to an encoder thread that does the
+ * file IO. If the ring or the encoder falls behind, the frame is dropped and
+ * counted instead of waiting.
+ */
+class FrameCapture
+{
+public:
+	FrameCapture();
+	~FrameCapture();
+
+	// Requires an active context
+	bool init();
+
+	bool start(const int &width, const int &height);
+	void stop();
+	bool isRecording() const;
+	unsigned int getWidth() const;
+	unsigned int getHeight() const;
+
+	// Queues a readback of the current back buffer and collects finished ones
+	void captureFrame();
+
+private:
+	struct Slot
+	{
+		GLuint pbo;
+		glext::GLsync fence;
+		int frame;
+	};
+
+	struct EncodedFrame
+	{
+		vector<unsigned char> pixels;
+		int frame;
+	};
+
+	bool supported;
+	bool recording;
+	int width, height;
+	int session;
+	int frame;
+	int next;
+	int dropped;
+	int written;
+
+	vector<Slot> slots;
+
+	thread encoder;
+	mutex queueMutex;
+	condition_variable queueCond;
+	deque<EncodedFrame*> queue;
+	vector<EncodedFrame*> freeFrames;
+	bool stopEncoder;
+
+	void collect(const bool &wait);
+	void encode();
+	void writeFrame(const EncodedFrame &f) const;
+};
+
+#endif /* FRAME_CAPTURE_H */
@@ -0,0 +1,87 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+using namespace std;
+
+FrameStats::FrameStats(const int &historySize)
+	: history(historySize, 0.0f)
+	, next(0)
+	, count(0)
+	, scratch(historySize, 0.0f)
+	, passes()
+{}
+
+void FrameStats::addFrame(const float &dt)
+{
+	history[next] = dt;
+	next = (next + 1) % history.size();
+	count = min(count + 1, (int)history.size());
+}
+
+void FrameStats::reset()
+{
+	next = 0;
+	count = 0;
+}
+
+int FrameStats::getFrameCount() const
+{
+	return count;
+}
+
+float FrameStats::getLastFrameTime() const
+{
+	if (count == 0) return 0.0f;
+	return history[(next + history.size() - 1) % history.size()];
+}
+
+float FrameStats::getMeanFrameTime() const
+{
+	if (count == 0) return 0.0f;
+
+	float sum = 0.0f;
+	for (int i = 0; i < count; ++i) sum += history[i];
+	return sum / count;
+}
+
+float FrameStats::getPercentileFrameTime(const float &percentile) const
+{
+	if (count == 0) return 0.0f;
+
+	copy(history.begin(), history.begin() + count, scratch.begin());
+	int k = min(count - 1, (int)(percentile * count));
+	nth_element(scratch.begin(), scratch.begin() + k, scratch.begin() + count);
+	return scratch[k];
+}
+
+int FrameStats::registerPass(const string &name)
+{
+	for (size_t i = 0; i < passes.size(); ++i)
+	{
+		if (passes[i].name == name) return (int)i;
+	}
+
+	PassTime p = { name, 0.0f };
+	passes.push_back(p);
+	return (int)passes.size() - 1;
+}
+
+void FrameStats::recordPassTime(const int &pass, const float &ms)
+{
+	passes[pass].ms = ms;
+}
+
+int FrameStats::getPassCount() const
+{
+	return (int)passes.size();
+}
+
+const string& FrameStats::getPassName(const int &pass) const
+{
+	return passes[pass].name;
+}
+
+float FrameStats::getPassTime(const int &pass) const
+{
+	return passes[pass].ms;
+}
@@ -0,0 +1,46 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <string>
+#include <vector>
+using namespace std;
+
+// Rolling frame time history plus the latest timing of each named render pass.
+class FrameStats
+{
+public:
+	FrameStats(const int &historySize);
+
+	void addFrame(const float &dt);
+	void reset();
+
+	int getFrameCount() const;
+	float getLastFrameTime() const;
+	float getMeanFrameTime() const;
+	float getPercentileFrameTime(const float &percentile) const;
+
+	int registerPass(const string &name);
+	void recordPassTime(const int &pass, const float &ms);
+
+	int getPassCount() const;
+	const string& getPassName(const int &pass) const;
+	float getPassTime(const int &pass) const;
+
+private:
+	struct PassTime
+	{
+		string name;
+		float ms;
+	};
+
+	vector<float> history;
+	int next;
+	int count;
+
+	// Sized like history, so percentiles allocate nothing per frame
+	mutable vector<float> scratch;
+
+	vector<PassTime> passes;
+};
+
+#endif /* FRAME_STATS_H */
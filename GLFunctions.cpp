@@ -0,0 +1,132 @@
+#include "GLFunctions.h"
+
+#include <SFML/Window/Context.hpp>
+
+namespace glext
+{
+	GenQueriesProc glGenQueries = nullptr;
+	DeleteQueriesProc glDeleteQueries = nullptr;
+	BeginQueryProc glBeginQuery = nullptr;
+	EndQueryProc glEndQuery = nullptr;
+	GetQueryObjectivProc glGetQueryObjectiv = nullptr;
+	GetQueryObjectui64vProc glGetQueryObjectui64v = nullptr;
+
+	GenBuffersProc glGenBuffers = nullptr;
+	DeleteBuffersProc glDeleteBuffers = nullptr;
+	BindBufferProc glBindBuffer = nullptr;
+	BufferDataProc glBufferData = nullptr;
+	MapBufferRangeProc glMapBufferRange = nullptr;
+	UnmapBufferProc glUnmapBuffer = nullptr;
+	FenceSyncProc glFenceSync = nullptr;
+	DeleteSyncProc glDeleteSync = nullptr;
+	ClientWaitSyncProc glClientWaitSync = nullptr;
+
+	CreateShaderProc glCreateShader = nullptr;
+	DeleteShaderProc glDeleteShader = nullptr;
+	ShaderSourceProc glShaderSource = nullptr;
+	CompileShaderProc glCompileShader = nullptr;
+	GetShaderivProc glGetShaderiv = nullptr;
+	GetShaderInfoLogProc glGetShaderInfoLog = nullptr;
+	CreateProgramProc glCreateProgram = nullptr;
+	DeleteProgramProc glDeleteProgram = nullptr;
+	AttachShaderProc glAttachShader = nullptr;
+	LinkProgramProc glLinkProgram = nullptr;
+	GetProgramivProc glGetProgramiv = nullptr;
+	GetProgramInfoLogProc glGetProgramInfoLog = nullptr;
+	UseProgramProc glUseProgram = nullptr;
+	GetUniformLocationProc glGetUniformLocation = nullptr;
+	Uniform1fProc glUniform1f = nullptr;
+	Uniform1iProc glUniform1i = nullptr;
+	Uniform3fProc glUniform3f = nullptr;
+	DispatchComputeProc glDispatchCompute = nullptr;
+	MemoryBarrierProc glMemoryBarrier = nullptr;
+	BindImageTextureProc glBindImageTexture = nullptr;
+
+	FramebufferTexture2DProc glFramebufferTexture2D = nullptr;
+	CheckFramebufferStatusProc glCheckFramebufferStatus = nullptr;
+	DrawBuffersProc glDrawBuffers = nullptr;
+
+	template <typename T>
+	static void loadFunction(T &proc, const char *name)
+	{
+		proc = reinterpret_cast<T>(sf::Context::getFunction(name));
+	}
+
+	void load()
+	{
+		static bool loaded = false;
+		if (loaded) return;
+
+		loadFunction(glGenQueries, "glGenQueries");
+		loadFunction(glDeleteQueries, "glDeleteQueries");
+		loadFunction(glBeginQuery, "glBeginQuery");
+		loadFunction(glEndQuery, "glEndQuery");
+		loadFunction(glGetQueryObjectiv, "glGetQueryObjectiv");
+		loadFunction(glGetQueryObjectui64v, "glGetQueryObjectui64v");
+
+		loadFunction(glGenBuffers, "glGenBuffers");
+		loadFunction(glDeleteBuffers, "glDeleteBuffers");
+		loadFunction(glBindBuffer, "glBindBuffer");
+		loadFunction(glBufferData, "glBufferData");
+		loadFunction(glMapBufferRange, "glMapBufferRange");
+		loadFunction(glUnmapBuffer, "glUnmapBuffer");
+		loadFunction(glFenceSync, "glFenceSync");
+		loadFunction(glDeleteSync, "glDeleteSync");
+		loadFunction(glClientWaitSync, "glClientWaitSync");
+
+		loadFunction(glCreateShader, "glCreateShader");
+		loadFunction(glDeleteShader, "glDeleteShader");
+		loadFunction(glShaderSource, "glShaderSource");
+		loadFunction(glCompileShader, "glCompileShader");
+		loadFunction(glGetShaderiv, "glGetShaderiv");
+		loadFunction(glGetShaderInfoLog, "glGetShaderInfoLog");
+		loadFunction(glCreateProgram, "glCreateProgram");
+		loadFunction(glDeleteProgram, "glDeleteProgram");
+		loadFunction(glAttachShader, "glAttachShader");
+		loadFunction(glLinkProgram, "glLinkProgram");
+		loadFunction(glGetProgramiv, "glGetProgramiv");
+		loadFunction(glGetProgramInfoLog, "glGetProgramInfoLog");
+		loadFunction(glUseProgram, "glUseProgram");
+		loadFunction(glGetUniformLocation, "glGetUniformLocation");
+		loadFunction(glUniform1f, "glUniform1f");
+		loadFunction(glUniform1i, "glUniform1i");
+		loadFunction(glUniform3f, "glUniform3f");
+		loadFunction(glDispatchCompute, "glDispatchCompute");
+		loadFunction(glMemoryBarrier, "glMemoryBarrier");
+		loadFunction(glBindImageTexture, "glBindImageTexture");
+
+		loadFunction(glFramebufferTexture2D, "glFramebufferTexture2D");
+		loadFunction(glCheckFramebufferStatus, "glCheckFramebufferStatus");
+		loadFunction(glDrawBuffers, "glDrawBuffers");
+
+		loaded = true;
+	}
+
+	bool hasTimerQueries()
+	{
+		return glGenQueries && glDeleteQueries && glBeginQuery && glEndQuery
+			&& glGetQueryObjectiv && glGetQueryObjectui64v;
+	}
+
+	bool hasPixelBuffers()
+	{
+		return glGenBuffers && glDeleteBuffers && glBindBuffer && glBufferData
+			&& glMapBufferRange && glUnmapBuffer
+			&& glFenceSync && glDeleteSync && glClientWaitSync;
+	}
+
+	bool hasComputeShaders()
+	{
+		return glCreateShader && glDeleteShader && glShaderSource && glCompileShader
+			&& glGetShaderiv && glGetShaderInfoLog
+			&& glCreateProgram && glDeleteProgram && glAttachShader && glLinkProgram
+			&& glGetProgramiv && glGetProgramInfoLog && glUseProgram
+			&& glGetUniformLocation && glUniform1f && glUniform1i && glUniform3f
+			&& glDispatchCompute && glMemoryBarrier && glBindImageTexture;
+	}
+
+	bool hasMultipleRenderTargets()
+	{
+		return glFramebufferTexture2D && glCheckFramebufferStatus && glDrawBuffers;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+#ifndef GL_FUNCTIONS_H
+#define GL_FUNCTIONS_H
+
+// windows.h is pulled in by SFML/OpenGL.hpp, keep it from defining min/max
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <SFML/OpenGL.hpp>
+
+#include <cstddef>
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+/*
+ * SFML only exposes OpenGL 1.1 through its headers, and on Windows that is
+ * also all opengl32.lib exports. Anything newer is loaded at runtime through
+ * sf::Context::getFunction, which requires an active context.
+ */
+
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT 0x0001
+#endif
+#ifndef GL_BGRA
+#define GL_BGRA 0x80E1
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_ALREADY_SIGNALED
+#define GL_ALREADY_SIGNALED 0x911A
+#endif
+#ifndef GL_CONDITION_SATISFIED
+#define GL_CONDITION_SATISFIED 0x911C
+#endif
+
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_COMPILE_STATUS
+#define GL_COMPILE_STATUS 0x8B81
+#endif
+#ifndef GL_LINK_STATUS
+#define GL_LINK_STATUS 0x8B82
+#endif
+#ifndef GL_INFO_LOG_LENGTH
+#define GL_INFO_LOG_LENGTH 0x8B84
+#endif
+#ifndef GL_WRITE_ONLY
+#define GL_WRITE_ONLY 0x88B9
+#endif
+#ifndef GL_RGBA8
+#define GL_RGBA8 0x8058
+#endif
+#ifndef GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#endif
+#ifndef GL_TEXTURE_FETCH_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#endif
+
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER 0x8D40
+#endif
+#ifndef GL_FRAMEBUFFER_COMPLETE
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#endif
+#ifndef GL_COLOR_ATTACHMENT0
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#endif
+#ifndef GL_COLOR_ATTACHMENT1
+#define GL_COLOR_ATTACHMENT1 0x8CE1
+#endif
+#ifndef GL_R32F
+#define GL_R32F 0x822E
+#endif
+#ifndef GL_RED
+#define GL_RED 0x1903
+#endif
+
+typedef unsigned long long GLuint64_t;
+
+namespace glext
+{
+	typedef struct __GLsync *GLsync;
+	typedef ptrdiff_t GLsizeiptr;
+	typedef ptrdiff_t GLintptr;
+
+	typedef void (APIENTRY *GenQueriesProc)(GLsizei n, GLuint *ids);
+	typedef void (APIENTRY *DeleteQueriesProc)(GLsizei n, const GLuint *ids);
+	typedef void (APIENTRY *BeginQueryProc)(GLenum target, GLuint id);
+	typedef void (APIENTRY *EndQueryProc)(GLenum target);
+	typedef void (APIENTRY *GetQueryObjectivProc)(GLuint id, GLenum pname, GLint *params);
+	typedef void (APIENTRY *GetQueryObjectui64vProc)(GLuint id, GLenum pname, GLuint64_t *params);
+
+	typedef void (APIENTRY *GenBuffersProc)(GLsizei n, GLuint *buffers);
+	typedef void (APIENTRY *DeleteBuffersProc)(GLsizei n, const GLuint *buffers);
+	typedef void (APIENTRY *BindBufferProc)(GLenum target, GLuint buffer);
+	typedef void (APIENTRY *BufferDataProc)(GLenum target, GLsizeiptr size, const void *data, GLenum usage);
+	typedef void* (APIENTRY *MapBufferRangeProc)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+	typedef GLboolean (APIENTRY *UnmapBufferProc)(GLenum target);
+	typedef GLsync (APIENTRY *FenceSyncProc)(GLenum condition, GLbitfield flags);
+	typedef void (APIENTRY *DeleteSyncProc)(GLsync sync);
+	typedef GLenum (APIENTRY *ClientWaitSyncProc)(GLsync sync, GLbitfield flags, GLuint64_t timeout);
+	typedef GLuint (APIENTRY *CreateShaderProc)(GLenum type);
+	typedef void (APIENTRY *DeleteShaderProc)(GLuint shader);
+	typedef void (APIENTRY *ShaderSourceProc)(GLuint shader, GLsizei count, const char *const *string, const GLint *length);
+	typedef void (APIENTRY *CompileShaderProc)(GLuint shader);
+	typedef void (APIENTRY *GetShaderivProc)(GLuint shader, GLenum pname, GLint *params);
+	typedef void (APIENTRY *GetShaderInfoLogProc)(GLuint shader, GLsizei bufSize, GLsizei *length, char *infoLog);
+	typedef GLuint (APIENTRY *CreateProgramProc)();
+	typedef void (APIENTRY *DeleteProgramProc)(GLuint program);
+	typedef void (APIENTRY *AttachShaderProc)(GLuint program, GLuint shader);
+	typedef void (APIENTRY *LinkProgramProc)(GLuint program);
+	typedef void (APIENTRY *GetProgramivProc)(GLuint program, GLenum pname, GLint *params);
+	typedef void (APIENTRY *GetProgramInfoLogProc)(GLuint program, GLsizei bufSize, GLsizei *length, char *infoLog);
+	typedef void (APIENTRY *UseProgramProc)(GLuint program);
+	typedef GLint (APIENTRY *GetUniformLocationProc)(GLuint program, const char *name);
+	typedef void (APIENTRY *Uniform1fProc)(GLint location, GLfloat v0);
+	typedef void (APIENTRY *Uniform1iProc)(GLint location, GLint v0);
+	typedef void (APIENTRY *Uniform3fProc)(GLint location, GLfloat v0, GLfloat v1, GLfloat v2);
+	typedef void (APIENTRY *DispatchComputeProc)(GLuint x, GLuint y, GLuint z);
+	typedef void (APIENTRY *MemoryBarrierProc)(GLbitfield barriers);
+	typedef void (APIENTRY *BindImageTextureProc)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+
+	typedef void (APIENTRY *FramebufferTexture2DProc)(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+	typedef GLenum (APIENTRY *CheckFramebufferStatusProc)(GLenum target);
+	typedef void (APIENTRY *DrawBuffersProc)(GLsizei n, const GLenum *bufs);
+
+	extern GenQueriesProc glGenQueries;
+	extern DeleteQueriesProc glDeleteQueries;
+	extern BeginQueryProc glBeginQuery;
+	extern EndQueryProc glEndQuery;
+	extern GetQueryObjectivProc glGetQueryObjectiv;
+	extern GetQueryObjectui64vProc glGetQueryObjectui64v;
+
+	extern GenBuffersProc glGenBuffers;
+	extern DeleteBuffersProc glDeleteBuffers;
+	extern BindBufferProc glBindBuffer;
+	extern BufferDataProc glBufferData;
+	extern MapBufferRangeProc glMapBufferRange;
+	extern UnmapBufferProc glUnmapBuffer;
+	extern FenceSyncProc glFenceSync;
+	extern DeleteSyncProc glDeleteSync;
+	extern ClientWaitSyncProc glClientWaitSync;
+
+	extern CreateShaderProc glCreateShader;
+	extern DeleteShaderProc glDeleteShader;
+	extern ShaderSourceProc glShaderSource;
+	extern CompileShaderProc glCompileShader;
+	extern GetShaderivProc glGetShaderiv;
+	extern GetShaderInfoLogProc glGetShaderInfoLog;
+	extern CreateProgramProc glCreateProgram;
+	extern DeleteProgramProc glDeleteProgram;
+	extern AttachShaderProc glAttachShader;
+	extern LinkProgramProc glLinkProgram;
+	extern GetProgramivProc glGetProgramiv;
+	extern GetProgramInfoLogProc glGetProgramInfoLog;
+	extern UseProgramProc glUseProgram;
+	extern GetUniformLocationProc glGetUniformLocation;
+	extern Uniform1fProc glUniform1f;
+	extern Uniform1iProc glUniform1i;
+	extern Uniform3fProc glUniform3f;
+	extern DispatchComputeProc glDispatchCompute;
+	extern MemoryBarrierProc glMemoryBarrier;
+	extern BindImageTextureProc glBindImageTexture;
+
+	extern FramebufferTexture2DProc glFramebufferTexture2D;
+	extern CheckFramebufferStatusProc glCheckFramebufferStatus;
+	extern DrawBuffersProc glDrawBuffers;
+
+	// Loads every entry point above. Must be called with a context active,
+	// missing functions are left null.
+	void load();
+
+	bool hasTimerQueries();
+	bool hasPixelBuffers();
+	bool hasComputeShaders();
+	bool hasMultipleRenderTargets();
+}
+
+#endif /* GL_FUNCTIONS_H */
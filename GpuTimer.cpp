@@ -0,0 +1,96 @@
+#include "GpuTimer.h"
+
+#include "GLFunctions.h"
+#include "Constants.h"
+
+GpuTimer::GpuTimer(FrameStats &stats)
+	: stats(stats)
+	, passes()
+	, frame(0)
+	, enabled(false)
+	, activePass(-1)
+{}
+
+GpuTimer::~GpuTimer()
+{
+	if (!enabled) return;
+
+	for (auto& p : passes)
+	{
+		glext::glDeleteQueries((GLsizei)p.queries.size(), &p.queries[0]);
+	}
+}
+
+bool GpuTimer::init()
+{
+	glext::load();
+	enabled = glext::hasTimerQueries();
+	return enabled;
+}
+
+int GpuTimer::addPass(const string &name)
+{
+	Pass p;
+	p.statsId = stats.registerPass(name);
+	p.queries.resize(GPU_TIMER_LATENCY, 0);
+	p.pending.resize(GPU_TIMER_LATENCY, false);
+	p.smoothedMs = 0.0f;
+
+	if (enabled) glext::glGenQueries(GPU_TIMER_LATENCY, &p.queries[0]);
+
+	passes.push_back(p);
+	return (int)passes.size() - 1;
+}
+
+void GpuTimer::begin(const int &pass)
+{
+	if (!enabled || activePass != -1) return;
+
+	// The query from GPU_TIMER_LATENCY frames ago is still in flight,
+	// skip this sample rather than waiting for it.
+	int slot = frame % GPU_TIMER_LATENCY;
+	if (passes[pass].pending[slot]) return;
+
+	glext::glBeginQuery(GL_TIME_ELAPSED, passes[pass].queries[slot]);
+	activePass = pass;
+}
+
+void GpuTimer::end(const int &pass)
+{
+	if (!enabled || activePass != pass) return;
+
+	glext::glEndQuery(GL_TIME_ELAPSED);
+	passes[pass].pending[frame % GPU_TIMER_LATENCY] = true;
+	activePass = -1;
+}
+
+void GpuTimer::endFrame()
+{
+	if (!enabled) return;
+
+	for (auto& p : passes) collect(p);
+	++frame;
+}
+
+void GpuTimer::collect(Pass &pass)
+{
+	// Walk from the oldest slot so the smoothed value sees results in order
+	for (int i = 1; i <= GPU_TIMER_LATENCY; ++i)
+	{
+		int slot = (frame + i) % GPU_TIMER_LATENCY;
+		if (!pass.pending[slot]) continue;
+
+		GLint available = 0;
+		glext::glGetQueryObjectiv(pass.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) continue;
+
+		GLuint64_t ns = 0;
+		glext::glGetQueryObjectui64v(pass.queries[slot], GL_QUERY_RESULT, &ns);
+		pass.pending[slot] = false;
+
+		float ms = (float)(ns / 1.0e6);
+		if (pass.smoothedMs == 0.0f) pass.smoothedMs = ms;
+		else pass.smoothedMs += (ms - pass.smoothedMs) * GPU_TIMER_SMOOTHING;
+		stats.recordPassTime(pass.statsId, pass.smoothedMs);
+	}
+}
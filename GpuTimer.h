@@ -0,0 +1,52 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "FrameStats.h"
+
+/*
+ * Times GL passes with GL_TIME_ELAPSED queries. Every pass owns a ring of
+ * GPU_TIMER_LATENCY queries, a query is only read back once the driver
+ * reports it available, so collecting results never waits on the GPU.
+ * Results are reported to the FrameStats the timer was created with.
+ */
+class GpuTimer
+{
+public:
+	GpuTimer(FrameStats &stats);
+	~GpuTimer();
+
+	// Requires an active context. Returns false when timer queries are unsupported,
+	// in which case every other call is a no-op.
+	bool init();
+
+	int addPass(const string &name);
+
+	void begin(const int &pass);
+	void end(const int &pass);
+
+	// Collects every finished query and advances to the next set
+	void endFrame();
+
+private:
+	struct Pass
+	{
+		int statsId;
+		vector<unsigned int> queries;
+		vector<bool> pending;
+		float smoothedMs;
+	};
+
+	FrameStats &stats;
+	vector<Pass> passes;
+	int frame;
+	bool enabled;
+	int activePass;
+
+	void collect(Pass &pass);
+};
+
+#endif /* GPU_TIMER_H */
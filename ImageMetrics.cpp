@@ -0,0 +1,110 @@
+#include "ImageMetrics.h"
+
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+static const int SSIM_WINDOW = 8;
+static const int SSIM_STRIDE = 4;
+
+// Rec. 601 luma, what SSIM is usually reported on
+static vector<double> luma(const vector<sf::Uint8> &image)
+{
+	vector<double> y(image.size() / 4);
+	for (size_t i = 0; i < y.size(); ++i)
+	{
+		y[i] = 0.299 * image[i*4 + 0] + 0.587 * image[i*4 + 1] + 0.114 * image[i*4 + 2];
+	}
+	return y;
+}
+
+double psnr(const vector<sf::Uint8> &a, const vector<sf::Uint8> &b)
+{
+	double sq = 0.0;
+	for (size_t i = 0; i < a.size(); i += 4)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			double d = (double)a[i + c] - b[i + c];
+			sq += d * d;
+		}
+	}
+
+	double mse = sq / (a.size() / 4 * 3);
+	if (mse == 0.0) return 100.0;
+	return min(100.0, 10.0 * log10(255.0 * 255.0 / mse));
+}
+
+double ssim(const vector<sf::Uint8> &a, const vector<sf::Uint8> &b, const sf::Vector2u &size)
+{
+	const double c1 = (0.01 * 255.0) * (0.01 * 255.0);
+	const double c2 = (0.03 * 255.0) * (0.03 * 255.0);
+	const double n = SSIM_WINDOW * SSIM_WINDOW;
+
+	vector<double> ya = luma(a);
+	vector<double> yb = luma(b);
+
+	double total = 0.0;
+	int windows = 0;
+	for (int y0 = 0; y0 + SSIM_WINDOW <= (int)size.y; y0 += SSIM_STRIDE)
+	{
+		for (int x0 = 0; x0 + SSIM_WINDOW <= (int)size.x; x0 += SSIM_STRIDE)
+		{
+			double sa = 0.0, sb = 0.0, saa = 0.0, sbb = 0.0, sab = 0.0;
+			for (int y = y0; y < y0 + SSIM_WINDOW; ++y)
+			{
+				for (int x = x0; x < x0 + SSIM_WINDOW; ++x)
+				{
+					double pa = ya[(size_t)y * size.x + x];
+					double pb = yb[(size_t)y * size.x + x];
+					sa += pa; sb += pb;
+					saa += pa * pa; sbb += pb * pb; sab += pa * pb;
+				}
+			}
+
+			double ma = sa / n, mb = sb / n;
+			double va = saa / n - ma * ma;
+			double vb = sbb / n - mb * mb;
+			double cov = sab / n - ma * mb;
+
+			total += (2.0 * ma * mb + c1) * (2.0 * cov + c2) / ((ma * ma + mb * mb + c1) * (va + vb + c2));
+			++windows;
+		}
+	}
+
+	return windows > 0 ? total / windows : 1.0;
+}
+
+vector<sf::Uint8> resizeBilinear(const vector<sf::Uint8> &image, const sf::Vector2u &from, const sf::Vector2u &to)
+{
+	if (from == to) return image;
+
+	vector<sf::Uint8> out((size_t)to.x * to.y * 4);
+	const float sx = (float)from.x / to.x;
+	const float sy = (float)from.y / to.y;
+
+	for (int y = 0; y < (int)to.y; ++y)
+	{
+		float fy = max(0.0f, (y + 0.5f) * sy - 0.5f);
+		int y0 = min((int)fy, (int)from.y - 1);
+		int y1 = min(y0 + 1, (int)from.y - 1);
+		float wy = fy - y0;
+
+		for (int x = 0; x < (int)to.x; ++x)
+		{
+			float fx = max(0.0f, (x + 0.5f) * sx - 0.5f);
+			int x0 = min((int)fx, (int)from.x - 1);
+			int x1 = min(x0 + 1, (int)from.x - 1);
+			float wx = fx - x0;
+
+			for (int c = 0; c < 4; ++c)
+			{
+				float top = image[((size_t)y0 * from.x + x0) * 4 + c] * (1.0f - wx) + image[((size_t)y0 * from.x + x1) * 4 + c] * wx;
+				float bottom = image[((size_t)y1 * from.x + x0) * 4 + c] * (1.0f - wx) + image[((size_t)y1 * from.x + x1) * 4 + c] * wx;
+				out[((size_t)y * to.x + x) * 4 + c] = (sf::Uint8)(top * (1.0f - wy) + bottom * wy + 0.5f);
+			}
+		}
+	}
+
+	return out;
+}
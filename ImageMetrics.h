@@ -0,0 +1,22 @@
+#ifndef IMAGE_METRICS_H
+#define IMAGE_METRICS_H
+
+#include <vector>
+using namespace std;
+
+#include <SFML/Config.hpp>
+#include <SFML/System/Vector2.hpp>
+
+// Images are RGBA8, rows from the top, and compared images have the same size
+
+// Peak signal to noise ratio over RGB in dB, capped at 100 for equal images
+double psnr(const vector<sf::Uint8> &a, const vector<sf::Uint8> &b);
+
+// Mean structural similarity of the luma over 8x8 windows every 4 pixels,
+// 1 for equal images
+double ssim(const vector<sf::Uint8> &a, const vector<sf::Uint8> &b, const sf::Vector2u &size);
+
+// Bilinear, pixel centres aligned, for scoring a lower resolution render
+vector<sf::Uint8> resizeBilinear(const vector<sf::Uint8> &image, const sf::Vector2u &from, const sf::Vector2u &to);
+
+#endif /* IMAGE_METRICS_H */
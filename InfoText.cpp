@@ -0,0 +1,32 @@
+#include "InfoText.h"
+
+#include <cstdio>
+#include <cstdarg>
+#include <algorithm>
+using namespace std;
+
+InfoText::InfoText()
+	: text()
+{}
+
+void InfoText::clear()
+{
+	text.clear();
+}
+
+void InfoText::append(const char *format, ...)
+{
+	char line[256];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+
+	length = min(length, (int)sizeof(line) - 1);
+	for (int i = 0; i < length; ++i) text += sf::String((sf::Uint32)(unsigned char)line[i]);
+}
+
+const sf::String& InfoText::getString() const
+{
+	return text;
+}
@@ -0,0 +1,26 @@
+#ifndef INFO_TEXT_H
+#define INFO_TEXT_H
+
+#include <SFML/System/String.hpp>
+
+/*
+ * The HUD text, rebuilt in place every frame with printf style lines.
+ * Characters go in one at a time, each fits the small string buffer of
+ * sf::String, and the text keeps its capacity, so once every glyph has been
+ * seen building it does not touch the heap.
+ */
+class InfoText
+{
+public:
+	InfoText();
+
+	void clear();
+	void append(const char *format, ...);
+
+	const sf::String& getString() const;
+
+private:
+	sf::String text;
+};
+
+#endif /* INFO_TEXT_H */
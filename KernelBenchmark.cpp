@@ -0,0 +1,224 @@
+#include "KernelBenchmark.h"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cstdlib>
+using namespace std;
+
+#include <SFML/System/Clock.hpp>
+
+#include "BenchmarkPoints.h"
+#include "Mandelbulb.h"
+#include "Constants.h"
+
+KernelBenchmark::KernelBenchmark()
+	: sets()
+	, results()
+	, counters()
+	, sink(0.0f)
+	, batchDistances(BENCH_POINTS)
+	, batchIterations(BENCH_POINTS, 0)
+	, batchPoints(BENCH_POINTS)
+{}
+
+int KernelBenchmark::run(const string &jsonFile)
+{
+	generatePoints();
+
+	if (BENCH_PERF_COUNTERS && !counters.open())
+	{
+		cout << "Hardware counters unavailable, timing only" << endl;
+	}
+	else if (counters.isOpen() && !counters.hasFlops())
+	{
+		cout << "GFLOP/s unavailable, FP_ARITH events need an Intel core from Broadwell on" << endl;
+	}
+
+	Matrix4 rotation;
+	rotation.setToRotation(Vector3f(0.0f, 1.0f, 0.0f), 30.0f);
+	const Vector3f axis = Vector3f::normalize(Vector3f(1.0f, 2.0f, 3.0f));
+
+	cout << left << setw(26) << "kernel" << setw(10) << "set"
+		 << right << setw(12) << "ns/eval" << setw(10) << "+-95%" << setw(14) << "Mevals/s";
+	if (counters.isOpen()) cout << setw(8) << "IPC" << setw(12) << "cyc/eval" << setw(10) << "GFLOP/s";
+	cout << endl;
+
+	measure("sdfMandelbulb", [](const Vector3f &p, const Matrix4 &) { return sdfMandelbulb(p, POWER); });
+	measureBatch("sdfMandelbulbBatch", [this](const PointSet &set)
+	{
+		const int count = (int)set.points.size();
+		sdfMandelbulbBatch(&set.x[0], &set.y[0], &set.z[0], count, POWER, MAX_ITER, &batchDistances[0], nullptr, &batchIterations[0]);
+
+		float sum = 0.0f;
+		for (int i = 0; i < count; ++i) sum += batchDistances[i];
+		return sum;
+	});
+	measure("sdfMandelbulb_trap", [](const Vector3f &p, const Matrix4 &) { float trap[4]; return sdfMandelbulb(p, POWER, trap) + trap[3]; });
+	measure("sdfMandelbulb_fast", [](const Vector3f &p, const Matrix4 &) { return sdfMandelbulb_fast(p); });
+
+	measure("Vector3f::normalize", [](const Vector3f &p, const Matrix4 &) { Vector3f v(p); return v.normalize().x; });
+	measure("Vector3f::cross", [&axis](const Vector3f &p, const Matrix4 &) { return Vector3f::cross(p, axis).x; });
+	measure("Vector3f::rotate", [&axis](const Vector3f &p, const Matrix4 &) { Vector3f v(p); return v.rotate(axis, 15.0f).x; });
+	measure("Vector3f::mul", [](const Vector3f &p, const Matrix4 &m) { Vector3f v(p); return v.mul(m).x; });
+	measure("Vector3f::rot", [](const Vector3f &p, const Matrix4 &m) { Vector3f v(p); return v.rot(m).x; });
+	measureBatch("Matrix4::transformPoints", [this, &rotation](const PointSet &set)
+	{
+		rotation.transformPoints(&set.points[0], &batchPoints[0], set.points.size());
+		return batchPoints[0].x + batchPoints[set.points.size() - 1].x;
+	});
+	measureBatch("Matrix4::rotateVectors", [this, &rotation](const PointSet &set)
+	{
+		rotation.rotateVectors(&set.points[0], &batchPoints[0], set.points.size());
+		return batchPoints[0].x + batchPoints[set.points.size() - 1].x;
+	});
+	measure("Matrix4::mul", [&rotation](const Vector3f &, const Matrix4 &m) { Matrix4 a(m); return a.mul(rotation).asArray()[0]; });
+	measure("Matrix4::inv", [](const Vector3f &, const Matrix4 &m) { Matrix4 a(m); return a.inv().asArray()[0]; });
+
+	if (!writeJson(jsonFile))
+	{
+		cout << "Unable to write " << jsonFile << endl;
+		return EXIT_FAILURE;
+	}
+
+	cout << "Results written to " << jsonFile << endl;
+	return EXIT_SUCCESS;
+}
+
+// Fixed seed, so every run and every build measures the same points
+void KernelBenchmark::generatePoints()
+{
+	mt19937 rng(BENCH_SEED);
+
+	PointSet near = { "near", surfacePoints(rng, BENCH_POINTS), {} };
+	PointSet far = { "far", farPoints(rng, BENCH_POINTS), {} };
+	PointSet interior = { "interior", interiorPoints(rng, BENCH_POINTS), {} };
+
+	sets.push_back(near);
+	sets.push_back(far);
+	sets.push_back(interior);
+
+	for (auto &set : sets)
+	{
+		for (const auto &p : set.points)
+		{
+			Matrix4 m;
+			m.set(p.x, p.y, p.z, 0.0f, 0.0f, 0.0f, 1.0f);
+			m.mul(Matrix4().setToRotation(Vector3f::normalize(p), p.length() * 90.0f));
+			set.matrices.push_back(m);
+
+			set.x.push_back(p.x);
+			set.y.push_back(p.y);
+			set.z.push_back(p.z);
+		}
+	}
+}
+
+template <typename F>
+void KernelBenchmark::measure(const string &kernel, F f)
+{
+	measureBatch(kernel, [&f](const PointSet &set)
+	{
+		float sum = 0.0f;
+		const size_t count = set.points.size();
+		for (size_t i = 0; i < count; ++i) sum += f(set.points[i], set.matrices[i]);
+		return sum;
+	});
+}
+
+template <typename F>
+void KernelBenchmark::measureBatch(const string &kernel, F f)
+{
+	for (const auto &set : sets)
+	{
+		// Passes are doubled until a sample is well above the clock resolution
+		int passes = 1;
+		while (timePasses(set, passes, f) < BENCH_MIN_SAMPLE_US) passes *= 2;
+
+		vector<double> ns;
+		double evals = (double)passes * set.points.size();
+		double us = 0.0;
+		counters.start();
+		for (int i = 0; i < BENCH_SAMPLES; ++i)
+		{
+			double sample = timePasses(set, passes, f);
+			ns.push_back(sample * 1000.0 / evals);
+			us += sample;
+		}
+
+		Result r = { kernel, set.name, summarize(ns), evals * BENCH_SAMPLES, us / 1.0e6, counters.stop() };
+		results.push_back(r);
+
+		cout << left << setw(26) << kernel << setw(10) << set.name << right << fixed
+			 << setprecision(2) << setw(12) << r.ns.mean << setw(10) << r.ns.ci95
+			 << setprecision(1) << setw(14) << 1000.0 / r.ns.mean;
+		if (counters.isOpen())
+		{
+			const PerfCounters::Reading &c = r.counters;
+			cout << setprecision(2) << setw(8) << c.instructions / c.cycles
+				 << setprecision(1) << setw(12) << c.cycles / r.evals;
+			if (c.hasFlops) cout << setprecision(2) << setw(10) << c.flops / r.seconds / 1.0e9;
+			else cout << setw(10) << "-";
+		}
+		cout << endl;
+	}
+}
+
+// Microseconds for passes runs over the set
+template <typename F>
+double KernelBenchmark::timePasses(const PointSet &set, const int &passes, F f)
+{
+	float sum = 0.0f;
+
+	sf::Clock clock;
+	for (int n = 0; n < passes; ++n) sum += f(set);
+	double us = (double)clock.getElapsedTime().asMicroseconds();
+
+	// Keeps the results alive so the kernels are not optimised away
+	sink = sink + sum;
+	return us;
+}
+
+bool KernelBenchmark::writeJson(const string &filename) const
+{
+	ofstream out(filename.c_str());
+	if (!out) return false;
+
+	out << "{\n"
+		<< "  \"benchmark\": \"kernels\",\n"
+		<< "  \"points\": " << BENCH_POINTS << ",\n"
+		<< "  \"samples\": " << BENCH_SAMPLES << ",\n"
+		<< "  \"results\": [\n";
+
+	out << setprecision(6);
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const Result &r = results[i];
+		out << "    { \"kernel\": \"" << r.kernel << "\", \"set\": \"" << r.set << "\""
+			<< ", \"ns_per_eval\": " << r.ns.mean
+			<< ", \"ci95\": " << r.ns.ci95
+			<< ", \"stddev\": " << r.ns.stddev
+			<< ", \"min\": " << r.ns.min
+			<< ", \"max\": " << r.ns.max
+			<< ", \"evals_per_second\": " << 1.0e9 / r.ns.mean;
+
+		if (counters.isOpen())
+		{
+			const PerfCounters::Reading &c = r.counters;
+			out << ", \"counters\": { \"cycles\": " << c.cycles
+				<< ", \"instructions\": " << c.instructions
+				<< ", \"ipc\": " << c.instructions / c.cycles
+				<< ", \"cycles_per_eval\": " << c.cycles / r.evals
+				<< ", \"evals_per_cycle\": " << r.evals / c.cycles
+				<< ", \"cache_misses_per_eval\": " << c.cacheMisses / r.evals
+				<< ", \"branch_misses_per_eval\": " << c.branchMisses / r.evals;
+			if (c.hasFlops) out << ", \"gflops\": " << c.flops / r.seconds / 1.0e9;
+			out << " }";
+		}
+
+		out << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+
+	out << "  ]\n}\n";
+	return (bool)out;
+}
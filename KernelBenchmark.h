@@ -0,0 +1,77 @@
+#ifndef KERNEL_BENCHMARK_H
+#define KERNEL_BENCHMARK_H
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "Vector3f.h"
+#include "Matrix4.h"
+#include "BenchmarkStats.h"
+#include "PerfCounters.h"
+
+/*
+ * Throughput of the distance estimators and the math library. Every kernel
+ * runs over three fixed point sets: points within BENCH_SURFACE_DISTANCE of
+ * the surface, far field points outside the bailout radius, and interior
+ * points whose orbit stays bounded. Each sample repeats the set until it
+ * takes BENCH_MIN_SAMPLE_US, BENCH_SAMPLES of them give ns/eval with a 95%
+ * confidence interval. Where hardware counters can be read they cover all
+ * samples of a kernel and set, for IPC, cycles per evaluation and GFLOP/s.
+ * Batched kernels take the whole set per call and are still reported per
+ * point, so they line up with their scalar versions.
+ */
+class KernelBenchmark
+{
+public:
+	KernelBenchmark();
+
+	// Prints a table and writes the results as JSON, returns the exit code
+	int run(const string &jsonFile);
+
+private:
+	struct PointSet
+	{
+		string name;
+		vector<Vector3f> points;
+		vector<Matrix4> matrices;  // One per point, for the matrix kernels
+		vector<float> x, y, z;     // The points as arrays, for the batched kernels
+	};
+
+	struct Result
+	{
+		string kernel;
+		string set;
+		SampleSummary ns;
+		double evals;    // Over all samples, what the counters cover
+		double seconds;
+		PerfCounters::Reading counters;
+	};
+
+	vector<PointSet> sets;
+	vector<Result> results;
+	PerfCounters counters;
+	volatile float sink;
+
+	// Output of the batched kernels, one per point
+	vector<float> batchDistances;
+	vector<int> batchIterations;
+	vector<Vector3f> batchPoints;
+
+	void generatePoints();
+
+	// f is called once per point
+	template <typename F>
+	void measure(const string &kernel, F f);
+
+	// f is called once per pass over the set
+	template <typename F>
+	void measureBatch(const string &kernel, F f);
+
+	template <typename F>
+	double timePasses(const PointSet &set, const int &passes, F f);
+
+	bool writeJson(const string &filename) const;
+};
+
+#endif /* KERNEL_BENCHMARK_H */
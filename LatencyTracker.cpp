@@ -0,0 +1,60 @@
+#include "LatencyTracker.h"
+
+#include <algorithm>
+
+#include "Constants.h"
+
+LatencyTracker::LatencyTracker(const int &historySize)
+	: clock()
+	, stamps(LATENCY_TRACKER_RING)
+	, sampled(0)
+	, published(0)
+	, presented(0)
+	, stats(historySize)
+{
+	for (auto &s : stamps) s.store(0, std::memory_order_relaxed);
+}
+
+void LatencyTracker::inputSampled()
+{
+	// Pairs with the fence in framePresented, a reader that sees the new
+	// stamp also sees sampled past the one it replaced
+	int seq = sampled.load(std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	stamps[seq % LATENCY_TRACKER_RING].store(clock.getElapsedTime().asMicroseconds(), std::memory_order_relaxed);
+	sampled.store(seq + 1, std::memory_order_release);
+}
+
+void LatencyTracker::statePublished()
+{
+	published.store(sampled.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+int LatencyTracker::beginFrame() const
+{
+	return published.load(std::memory_order_acquire);
+}
+
+void LatencyTracker::framePresented(const int &published)
+{
+	sf::Int64 now = clock.getElapsedTime().asMicroseconds();
+
+	// Stamps the input thread has lapped since are lost, not misreported.
+	// Slot seq is rewritten once sampled reaches seq + LATENCY_TRACKER_RING,
+	// so a read is only kept if that had not happened by the time it ended.
+	int first = max(presented, published - LATENCY_TRACKER_RING + 1);
+	for (int seq = first; seq < published; ++seq)
+	{
+		sf::Int64 stamp = stamps[seq % LATENCY_TRACKER_RING].load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (sampled.load(std::memory_order_relaxed) >= seq + LATENCY_TRACKER_RING) continue;
+		stats.addFrame((now - stamp) / 1.0e6f);
+	}
+
+	presented = max(presented, published);
+}
+
+const FrameStats& LatencyTracker::getStats() const
+{
+	return stats;
+}
@@ -0,0 +1,46 @@
+#ifndef LATENCY_TRACKER_H
+#define LATENCY_TRACKER_H
+
+#include <vector>
+#include <atomic>
+using namespace std;
+
+#include <SFML/System/Clock.hpp>
+
+#include "FrameStats.h"
+
+/*
+ * Measures input to display latency. Every input event is stamped when the
+ * engine reads it, and once a state built from it has been published, the
+ * first frame presented after that reports how long the event took to reach
+ * window->display(). Stamps are written by the input thread and read back by
+ * the render thread, a ring of LATENCY_TRACKER_RING pending stamps sits
+ * between them without locking. Its slots are atomic and a stamp the input
+ * thread may have overwritten while it was read is dropped.
+ */
+class LatencyTracker
+{
+public:
+	LatencyTracker(const int &historySize);
+
+	// Input thread
+	void inputSampled();
+	void statePublished();
+
+	// Render thread, call before drawing and after display respectively
+	int beginFrame() const;
+	void framePresented(const int &published);
+
+	// Latencies in seconds, one sample per event
+	const FrameStats& getStats() const;
+
+private:
+	sf::Clock clock;
+	vector<std::atomic<sf::Int64>> stamps;
+	std::atomic<int> sampled;
+	std::atomic<int> published;
+	int presented;
+	FrameStats stats;
+};
+
+#endif /* LATENCY_TRACKER_H */
@@ -0,0 +1,271 @@
+#include "Mandelbulb.h"
+
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+using namespace std;
+
+#include "Constants.h"
+
+float inversesqrt(float n)
+{
+	int32_t i;
+	float x2, y;
+	const float threehalfs = 1.5F;
+
+	// Bits copied rather than cast, long is 64 bit outside Windows
+	x2 = n * 0.5F;
+	y  = n;
+	memcpy(&i, &y, sizeof(i));
+	i  = 0x5f3759df - ( i >> 1 );
+	memcpy(&y, &i, sizeof(y));
+	y  = y * ( threehalfs - ( x2 * y * y ) );
+
+	return y;
+}
+
+float sdfMandelbulb_fast(const Vector3f &p)
+{
+	Vector3f q = p;
+	float m = q.dot(q);
+	float dr = 1.0f;
+
+	for (int i = 0; i < 4; ++i)
+	{
+		float m2 = m*m;
+		float m4 = m2*m2;
+		dr =  8.0f*sqrt(m4*m2*m)*dr + 1.0f;
+
+		float x = q.x; float x2 = x*x; float x4 = x2*x2;
+		float y = q.y; float y2 = y*y; float y4 = y2*y2;
+		float z = q.z; float z2 = z*z; float z4 = z2*z2;
+
+		float k3 = x2 + z2;
+		float k2 = inversesqrt( k3*k3*k3*k3*k3*k3*k3 );
+		float k1 = x4 + y4 + z4 - 6.0f*y2*z2 - 6.0f*x2*y2 + 2.0f*z2*x2;
+        float k4 = x2 - y2 + z2;
+
+        q.x = p.x +  64.0f*x*y*z*(x2-z2)*k4*(x4-6.0f*x2*z2+z4)*k1*k2;
+        q.y = p.y + -16.0f*y2*k3*k4*k4 + k1*k1;
+        q.z = p.z +  -8.0f*y*k4*(x4*x4 - 28.0f*x4*x2*z2 + 70.0f*x4*z4 - 28.0f*x2*z2*z4 + z4*z4)*k1*k2;
+
+        m = q.dot(q);
+		if( m > 256.0f )
+            break;
+	}
+
+	return 0.25f*log(m)*sqrt(m)/dr;
+}
+
+float sdfMandelbulb(const Vector3f &p, const int &power)
+{
+	float trap[4];
+	return sdfMandelbulb(p, power, trap);
+}
+
+float sdfMandelbulb(const Vector3f &p, const int &power, float trap[4])
+{
+	int iterations = 0;
+	return sdfMandelbulb(p, power, MAX_ITER, trap, iterations);
+}
+
+float sdfMandelbulb(const Vector3f &p, const int &power, const int &maxIter, float trap[4], int &iterations)
+{
+	Vector3f q(p);
+	float r = q.length();
+	float dr = 1.0f;
+
+	trap[0] = abs(q.x); trap[1] = abs(q.y); trap[2] = abs(q.z); trap[3] = r;
+
+	int i = maxIter;
+	while (r < MAX_BAILOUT && i-- > 0)
+	{
+		float ph = asinf( q.z/r );
+		float th = atanf( q.y / q.x );
+		float zr = powf( r, power - 1.0f );
+
+		dr = zr * dr * power + 1.0f;
+		zr *= r;
+
+		float sph = sin(power*ph); float cph = cos(power*ph);
+		float sth = sin(power*th); float cth = cos(power*th);
+
+        q.x = zr * cph*cth + p.x;
+		q.y = zr * cph*sth + p.y;
+		q.z = zr * sph     + p.z;
+
+		trap[0] = min(trap[0], abs(q.x)); trap[1] = min(trap[1], abs(q.y));
+		trap[2] = min(trap[2], abs(q.z)); trap[3] = min(trap[3], r);
+		r = q.length();
+		++iterations;
+	}
+
+	return 0.5f*log(r)*r/dr;
+}
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+
+#include <emmintrin.h>
+
+// How often the angles double to reach power, -1 unless it is a power of two
+static int doublings(const int &power)
+{
+	int n = 0;
+	while ((1 << n) < power) ++n;
+	return (power > 1 && (1 << n) == power) ? n : -1;
+}
+
+static __m128 absPs(const __m128 &v)
+{
+	return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+
+// Lanes of mask from a, the rest from b
+static __m128 select(const __m128 &mask, const __m128 &a, const __m128 &b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Four orbits of sdfMandelbulb side by side. atan(y/x) and asin(z/r) are
+// only ever multiplied and fed to sin and cos, so their cosines and sines
+// are taken straight from the point and doubled. atan's branch differs from
+// atan2 by pi, which an even power cancels. Finished lanes keep their values.
+static void sdfMandelbulb4(const float *px, const float *py, const float *pz, const int &power, const int &n,
+	const int &maxIter, float *h, float *trap, int *iterations)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 bailout = _mm_set1_ps(MAX_BAILOUT);
+	const __m128 powerPs = _mm_set1_ps((float)power);
+
+	const __m128 cx = _mm_loadu_ps(px), cy = _mm_loadu_ps(py), cz = _mm_loadu_ps(pz);
+	__m128 x = cx, y = cy, z = cz;
+	__m128 r = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+	__m128 dr = one;
+	__m128 trapX = absPs(x), trapY = absPs(y), trapZ = absPs(z), trapR = r;
+	__m128 count = zero;
+
+	__m128 active = _mm_cmplt_ps(r, bailout);
+	for (int i = 0; i < maxIter && _mm_movemask_ps(active) != 0; ++i)
+	{
+		__m128 rxy = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+
+		// On the z axis the angle is undefined, take theta 0
+		__m128 axis = _mm_cmpeq_ps(rxy, zero);
+		__m128 invXy = _mm_div_ps(one, select(axis, one, rxy));
+		__m128 cth = select(axis, one, _mm_mul_ps(x, invXy));
+		__m128 sth = _mm_andnot_ps(axis, _mm_mul_ps(y, invXy));
+
+		__m128 invR = _mm_div_ps(one, r);
+		__m128 cph = _mm_mul_ps(rxy, invR);
+		__m128 sph = _mm_mul_ps(z, invR);
+
+		__m128 zr = r;
+		for (int k = 0; k < n; ++k)
+		{
+			__m128 c = _mm_sub_ps(_mm_mul_ps(cth, cth), _mm_mul_ps(sth, sth));
+			sth = _mm_mul_ps(_mm_add_ps(cth, cth), sth);
+			cth = c;
+
+			c = _mm_sub_ps(_mm_mul_ps(cph, cph), _mm_mul_ps(sph, sph));
+			sph = _mm_mul_ps(_mm_add_ps(cph, cph), sph);
+			cph = c;
+
+			zr = _mm_mul_ps(zr, zr);
+		}
+
+		// zr is r^power, dr takes r^(power - 1)
+		__m128 nextDr = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(zr, invR), dr), powerPs), one);
+		__m128 nextX = _mm_add_ps(_mm_mul_ps(zr, _mm_mul_ps(cph, cth)), cx);
+		__m128 nextY = _mm_add_ps(_mm_mul_ps(zr, _mm_mul_ps(cph, sth)), cy);
+		__m128 nextZ = _mm_add_ps(_mm_mul_ps(zr, sph), cz);
+
+		trapX = select(active, _mm_min_ps(trapX, absPs(nextX)), trapX);
+		trapY = select(active, _mm_min_ps(trapY, absPs(nextY)), trapY);
+		trapZ = select(active, _mm_min_ps(trapZ, absPs(nextZ)), trapZ);
+		trapR = select(active, _mm_min_ps(trapR, r), trapR);
+
+		dr = select(active, nextDr, dr);
+		x = select(active, nextX, x);
+		y = select(active, nextY, y);
+		z = select(active, nextZ, z);
+		r = select(active, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z))), r);
+		count = _mm_add_ps(count, _mm_and_ps(active, one));
+
+		active = _mm_and_ps(active, _mm_cmplt_ps(r, bailout));
+	}
+
+	float rs[4], drs[4], counts[4], traps[4][4];
+	_mm_storeu_ps(rs, r);
+	_mm_storeu_ps(drs, dr);
+	_mm_storeu_ps(counts, count);
+	_mm_storeu_ps(traps[0], trapX);
+	_mm_storeu_ps(traps[1], trapY);
+	_mm_storeu_ps(traps[2], trapZ);
+	_mm_storeu_ps(traps[3], trapR);
+
+	for (int j = 0; j < 4; ++j)
+	{
+		h[j] = 0.5f*log(rs[j])*rs[j]/drs[j];
+		iterations[j] += (int)counts[j];
+		if (trap == nullptr) continue;
+		for (int k = 0; k < 4; ++k) trap[j * 4 + k] = traps[k][j];
+	}
+}
+
+void sdfMandelbulbBatch(const float *x, const float *y, const float *z, const int &count, const int &power,
+	const int &maxIter, float *h, float *trap, int *iterations)
+{
+	const int n = doublings(power);
+
+	int i = 0;
+	if (n > 0)
+	{
+		for (; i + 4 <= count; i += 4)
+		{
+			sdfMandelbulb4(x + i, y + i, z + i, power, n, maxIter, h + i, trap ? trap + i * 4 : nullptr, iterations + i);
+		}
+
+		// The tail padded with copies of its last point
+		if (i < count)
+		{
+			float px[4], py[4], pz[4], ph[4], ptrap[16];
+			int pi[4] = { 0, 0, 0, 0 };
+			for (int j = 0; j < 4; ++j)
+			{
+				int k = min(i + j, count - 1);
+				px[j] = x[k]; py[j] = y[k]; pz[j] = z[k];
+			}
+
+			sdfMandelbulb4(px, py, pz, power, n, maxIter, ph, ptrap, pi);
+			for (int j = 0; i + j < count; ++j)
+			{
+				h[i + j] = ph[j];
+				iterations[i + j] += pi[j];
+				if (trap != nullptr) memcpy(trap + (i + j) * 4, ptrap + j * 4, 4 * sizeof(float));
+			}
+			i = count;
+		}
+	}
+
+	float scratch[4];
+	for (; i < count; ++i)
+	{
+		h[i] = sdfMandelbulb(Vector3f(x[i], y[i], z[i]), power, maxIter, trap ? trap + i * 4 : scratch, iterations[i]);
+	}
+}
+
+#else
+
+void sdfMandelbulbBatch(const float *x, const float *y, const float *z, const int &count, const int &power,
+	const int &maxIter, float *h, float *trap, int *iterations)
+{
+	float scratch[4];
+	for (int i = 0; i < count; ++i)
+	{
+		h[i] = sdfMandelbulb(Vector3f(x[i], y[i], z[i]), power, maxIter, trap ? trap + i * 4 : scratch, iterations[i]);
+	}
+}
+
+#endif
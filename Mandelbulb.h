@@ -0,0 +1,29 @@
+#ifndef MANDELBULB_H
+#define MANDELBULB_H
+
+#include "Vector3f.h"
+
+float inversesqrt(float n);
+
+// Distance estimate of the power-n bulb, the same one mandelbulb_march.glsl marches
+float sdfMandelbulb(const Vector3f &p, const int &power);
+
+// Also returns the orbit trap the shaders colour with: the smallest |x|, |y|,
+// |z| and radius the orbit reached
+float sdfMandelbulb(const Vector3f &p, const int &power, float trap[4]);
+
+// Iterates at most maxIter times and adds the iterations the orbit took to iterations
+float sdfMandelbulb(const Vector3f &p, const int &power, const int &maxIter, float trap[4], int &iterations);
+
+// Distance estimates of count points given as x, y and z arrays, four at a
+// time with SSE. The orbit is the one above with the angles multiplied by
+// doubling, so a power of two needs no trigonometry, other powers fall back
+// to the scalar version. trap holds four values per point, iterations is
+// added to per point like above.
+void sdfMandelbulbBatch(const float *x, const float *y, const float *z, const int &count, const int &power,
+	const int &maxIter, float *h, float *trap, int *iterations);
+
+// Power 8 only, polynomial form without trigonometry
+float sdfMandelbulb_fast(const Vector3f &p);
+
+#endif /* MANDELBULB_H */
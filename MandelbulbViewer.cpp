@@ -1,10 +1,14 @@
 #include "MandelbulbViewer.h"
 
 #include "Constants.h"
+#include "ShaderSource.h"
+#include "RenderBenchmark.h"
 
 #include <iostream>
-#include <sstream>
+#include <cstdio>
 #include <cstdlib>
+#include <cmath>
+#include <algorithm>
 using namespace std;
 
 MandelbulbViewer::MandelbulbViewer(const int &windowWidth, const int &windowHeight, const int& max_fps)
@@ -12,16 +16,64 @@ MandelbulbViewer::MandelbulbViewer(const int &windowWidth, const int &windowHeig
 	, viewer(new MandelbulbViewer::ViewerInputListener())
 	, cam(new CameraController((float)windowWidth, (float)windowHeight))
 	, shader(new sf::Shader())
+	, vertSource()
+	, fragSource()
 	, quad(nullptr)
 	, infoFont()
 	, info()
+	, infoText()
 	, infoBg()
+	, gpuTimer(nullptr)
+	, marchPass(-1)
+	, hudPass(-1)
+	, capture(new FrameCapture())
+	, computeShader(new ComputeShader())
+	, computeTarget(new sf::Texture())
+	, computeSprite()
+	, computeSupported(false)
+	, marcher(new AsyncMarcher())
+	, warpShader(new sf::Shader())
+	, warpSupported(false)
+	, warpFailed(false)
+	, cpuBackend(false)
+	, cpuRenderer(new CpuRenderer())
+	, cpuSprite()
+	, views()
+	, mindist(0.0f)
+	, captureFailed(false)
+	, path(new CameraPath())
+	, recording(false)
+	, playing(false)
+	, playbackTime(0.0f)
+	, playbackFrameTimes(nullptr)
+	, playbackGpuTimes(nullptr)
+	, steadyState(false)
+	, lastAllocations()
+	, frameAllocations(0)
+	, frameAllocatedBytes(0)
+	, allocFrames(0)
+	, allocatingFrames(0)
+	, playbackAllocations(0)
+	, playbackMaxAllocations(0)
 {
 	this->engine = new Engine("Mandelbulb Viewer", windowWidth, windowHeight, max_fps);
+	this->gpuTimer = new GpuTimer(engine->getFrameStats());
+
+	if (ALLOC_TRACKING) AllocTracker::setEnabled(true);
 }
 
 MandelbulbViewer::~MandelbulbViewer()
 {
+	if(gpuTimer != nullptr) delete gpuTimer;
+	if(capture != nullptr) delete capture;
+	if(computeShader != nullptr) delete computeShader;
+	if(computeTarget != nullptr) delete computeTarget;
+	if(marcher != nullptr) delete marcher;
+	if(cpuRenderer != nullptr) delete cpuRenderer;
+	if(warpShader != nullptr) delete warpShader;
+	if(path != nullptr) delete path;
+	if(playbackFrameTimes != nullptr) delete playbackFrameTimes;
+	if(playbackGpuTimes != nullptr) delete playbackGpuTimes;
 	if(engine != nullptr) delete engine;
 	if(viewer != nullptr) delete viewer;
 	if(cam != nullptr) delete cam;
@@ -36,28 +88,120 @@ int MandelbulbViewer::run()
 	engine->setPreupdateFunc(std::bind(&MandelbulbViewer::preupdate, this));
 	engine->setUpdateFunc(std::bind(&MandelbulbViewer::update, this, std::placeholders::_1));
 	engine->setDrawFunc(std::bind(&MandelbulbViewer::draw, this));
+	engine->setLatchFunc(std::bind(&MandelbulbViewer::publishState, this));
 
-	return engine->run();
+	int result = engine->run();
+	if (steadyState && reportSteadyState() != EXIT_SUCCESS) return EXIT_FAILURE;
+	return result;
 }
 
-void MandelbulbViewer::init()
+void MandelbulbViewer::setCpuBackend(const bool &cpu)
 {
-	if (!sf::Shader::isAvailable())
+	cpuBackend = cpu;
+}
+
+void MandelbulbViewer::setSteadyState(const bool &steady)
+{
+	steadyState = steady;
+	if (steady) AllocTracker::setEnabled(true);
+}
+
+int MandelbulbViewer::playback(const string &filename)
+{
+	if (!path->load(filename) || path->size() < 2)
 	{
-		std::cout << "Shading not supported!" << std::endl;
-		system("PAUSE");
-		exit(EXIT_FAILURE);
+		std::cout << "Unable to load flythrough " << filename << std::endl;
+		return EXIT_FAILURE;
 	}
-	if (!shader->loadFromFile("mandelbulb.vert", "mandelbulb.frag"))
+
+	int frames = (int)(path->getDuration() / PLAYBACK_TIMESTEP) + 1;
+	playbackFrameTimes = new FrameStats(frames);
+	playbackGpuTimes = new FrameStats(frames);
+	playbackTime = 0.0f;
+	playing = true;
+
+	// Frames must pair one to one with simulation steps, and nothing may
+	// move the camera after the path has placed it
+	engine->setThreadedUpdate(false);
+	engine->setLateLatch(false);
+
+	std::cout << "Playing back " << filename << ": " << path->size() << " keys, "
+		<< frames << " frames" << std::endl;
+	return run();
+}
+
+int MandelbulbViewer::verifyCompute()
+{
+	sf::RenderWindow *window = engine->getWindow();
+	window->setActive(true);
+	init();
+
+	if (!computeSupported)
 	{
-		// some error occurred
- 		std::cout << "Unable to load shaders." << std::endl;
-		system("PAUSE");
-		exit(EXIT_FAILURE);
+		std::cout << "Compute path unavailable, nothing to verify." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// Not symmetric top to bottom, so a flipped image cannot pass
+	ViewState state = RenderBenchmark::referencePoses()[2].second;
+
+	// Fragment path, copied out of the back buffer
+	sf::Shader::bind(shader);
+	setUniforms(*shader, state, engine->getWindow()->getSize());
+	sf::Shader::bind(NULL);
+	window->clear(sf::Color::Black);
+	window->draw(*quad, shader);
+
+	sf::Vector2u size = window->getSize();
+	sf::Texture fragTarget;
+	fragTarget.create(size.x, size.y);
+	fragTarget.update(*window);
+	sf::Image fragImage = fragTarget.copyToImage();
+
+	// Compute path, straight from its target
+	setUniforms(*computeShader, state, engine->getWindow()->getSize());
+	computeShader->dispatch(computeTarget->getNativeHandle()
+		, (size.x + COMPUTE_TILE_SIZE - 1) / COMPUTE_TILE_SIZE
+		, (size.y + COMPUTE_TILE_SIZE - 1) / COMPUTE_TILE_SIZE);
+	sf::Image compImage = computeTarget->copyToImage();
+
+	double sumDiff = 0.0;
+	float maxDiff = 0.0f;
+	int mismatched = 0;
+	for (unsigned int y = 0; y < size.y; ++y)
+	{
+		for (unsigned int x = 0; x < size.x; ++x)
+		{
+			sf::Color a = fragImage.getPixel(x, y);
+			sf::Color b = compImage.getPixel(x, y);
+
+			float diff = max(abs(a.r - b.r), max(abs(a.g - b.g), abs(a.b - b.b))) / 255.0f;
+			sumDiff += diff;
+			maxDiff = max(maxDiff, diff);
+			if (diff > COMPUTE_VERIFY_PIXEL_TOLERANCE) ++mismatched;
+		}
+	}
+
+	float pixels = (float)(size.x * size.y);
+	float mismatchRate = mismatched / pixels;
+	bool passed = mismatchRate <= COMPUTE_VERIFY_MAX_MISMATCH;
+
+	std::cout << "compute vs fragment: mean diff " << sumDiff / pixels
+		<< ", max diff " << maxDiff
+		<< ", " << mismatchRate * 100.0f << "% of pixels over " << COMPUTE_VERIFY_PIXEL_TOLERANCE
+		<< (passed ? " - PASSED" : " - FAILED") << std::endl;
+
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void MandelbulbViewer::init()
+{
+	if (!cpuBackend && !initShaders())
+	{
+		std::cout << "Falling back to the CPU backend." << std::endl;
+		cpuBackend = true;
 	}
 
-	float screenWidth = (float)engine->getWindow()->getSize().x;
-	float screenHeight = (float)engine->getWindow()->getSize().y;
 	quad = new sf::RectangleShape(sf::Vector2f(engine->getWindow()->getSize()));
 
 	infoBg.setFillColor(sf::Color(0, 0, 0, 150));
@@ -73,6 +217,48 @@ void MandelbulbViewer::init()
 	info.setCharacterSize(INFO_FONT_SIZE_PX);
 	info.setFillColor(sf::Color::White);
 
+	if (!gpuTimer->init())
+		std::cout << "GPU timer queries not supported, pass timings disabled." << std::endl;
+	marchPass = gpuTimer->addPass("march");
+	hudPass = gpuTimer->addPass("hud");
+
+	if (!capture->init())
+		std::cout << "Pixel buffer objects not supported, capture disabled." << std::endl;
+
+	if (cpuBackend)
+	{
+		cpuRenderer->start(CPU_RENDER_THREADS);
+		std::cout << "Rendering on " << cpuRenderer->getThreadCount() << " CPU threads." << std::endl;
+	}
+	else
+	{
+		initCompute();
+	}
+
+	engine->registerInputListener(viewer);
+	engine->registerInputListener(cam);
+}
+
+// Loads the march and timewarp shaders, false when the GPU backend cannot run
+bool MandelbulbViewer::initShaders()
+{
+	if (!sf::Shader::isAvailable())
+	{
+		std::cout << "Shading not supported!" << std::endl;
+		return false;
+	}
+	if (!loadShaderSource("mandelbulb.vert", vertSource)
+		|| !loadShaderSource("mandelbulb.frag", fragSource)
+		|| !shader->loadFromMemory(vertSource, fragSource))
+	{
+		// some error occurred
+ 		std::cout << "Unable to load shaders." << std::endl;
+		return false;
+	}
+
+	float screenWidth = (float)engine->getWindow()->getSize().x;
+	float screenHeight = (float)engine->getWindow()->getSize().y;
+
 	sf::Shader::bind(shader);
 	sf::Transform viewMatrix = engine->getWindow()->getView().getTransform();
 	shader->setUniform("projViewMatrix", (sf::Glsl::Mat4)viewMatrix.getMatrix());
@@ -80,8 +266,54 @@ void MandelbulbViewer::init()
 	shader->setUniform("screen_height", screenHeight);
 	sf::Shader::bind(NULL);
 
-	engine->registerInputListener(viewer);
-	engine->registerInputListener(cam);
+	string warpSource;
+	warpSupported = loadShaderSource("timewarp.frag", warpSource)
+		&& warpShader->loadFromMemory(vertSource, warpSource);
+	if (warpSupported)
+	{
+		sf::Shader::bind(warpShader);
+		warpShader->setUniform("projViewMatrix", (sf::Glsl::Mat4)viewMatrix.getMatrix());
+		sf::Shader::bind(NULL);
+	}
+	else
+	{
+		std::cout << "Unable to load timewarp shader, async march disabled." << std::endl;
+	}
+
+	return true;
+}
+
+void MandelbulbViewer::initCompute()
+{
+	sf::ContextSettings settings = engine->getWindow()->getSettings();
+	bool hasVersion = settings.majorVersion > 4 || (settings.majorVersion == 4 && settings.minorVersion >= 3);
+
+	string compSource;
+	computeSupported = hasVersion
+		&& loadShaderSource("mandelbulb.comp", compSource)
+		&& computeShader->loadFromMemory(compSource);
+
+	if (!computeSupported)
+	{
+		std::cout << "Compute shaders not supported, compute path disabled." << std::endl;
+		return;
+	}
+
+	resizeComputeTarget();
+}
+
+void MandelbulbViewer::resizeComputeTarget()
+{
+	sf::Vector2u size = engine->getWindow()->getSize();
+	if (computeTarget->getSize() == size) return;
+
+	computeTarget->create(size.x, size.y);
+	computeSprite.setTexture(*computeTarget, true);
+}
+
+bool MandelbulbViewer::useCompute(const ViewState &state) const
+{
+	return computeSupported && state.computeToggle;
 }
 
 void MandelbulbViewer::preupdate()
@@ -91,104 +323,466 @@ void MandelbulbViewer::preupdate()
 
 void MandelbulbViewer::update(const float dt)
 {
-	// this is when the camera needs to be passed to the shader
-	sf::Shader::bind(shader);
+	if (playing) updatePlayback(dt);
+	else updateRecording(dt);
+
+	if (!playing) engine->setLateLatch(viewer->latchToggle);
+
+	// Only the HUD shows it and it is not cheap
+	mindist = viewer->infoToggle ? cam->camera->estimateMandelbulbDistance() : 0.0f;
+
+	publishState();
+}
 
-	sf::Vector3f camera_position = cam->camera->position.asSFML();
-	shader->setUniform("camera_position", (sf::Glsl::Vec3)camera_position);
+// Runs on the simulation thread, nothing in here may touch GL. Also the
+// engine's latch function, which republishes input read right before drawing.
+void MandelbulbViewer::publishState()
+{
+	ViewState &state = views.getWriteBuffer();
+
+	state.cameraPosition = cam->camera->position;
+	state.cameraDirection = cam->camera->direction;
+	state.cameraUp = cam->camera->up;
+	state.cameraVelocity = cam->getVelocity();
+	state.scale = cam->camera->scale();
+	state.speed = cam->getSpeed();
+	state.mindist = mindist;
+
+	state.infoToggle = viewer->infoToggle;
+	state.fogToggle = viewer->fogToggle;
+	state.glowToggle = viewer->glowToggle;
+	state.heatToggle = viewer->heatToggle;
+	state.shadowToggle = viewer->shadowToggle;
+	state.aoToggle = viewer->aoToggle;
+	state.captureToggle = viewer->captureToggle;
+	state.computeToggle = viewer->computeToggle;
+	state.warpToggle = viewer->warpToggle;
+
+	engine->publishWithLook([this]{ views.publish(); });
+}
 
-	sf::Vector3f camera_direction = cam->camera->direction.asSFML();
-	shader->setUniform("camera_direction", (sf::Glsl::Vec3)camera_direction);
+// Shared by the fragment and the compute path, both take the same uniforms
+template <typename S>
+void MandelbulbViewer::setUniforms(S &s, const ViewState &state, const sf::Vector2u &size)
+{
+	sf::Vector3f camera_position = state.cameraPosition.asSFML();
+	s.setUniform("camera_position", (sf::Glsl::Vec3)camera_position);
 
-	sf::Vector3f camera_up = cam->camera->up.asSFML();
-	shader->setUniform("camera_up", (sf::Glsl::Vec3)camera_up);
+	// Names longer than the small string buffer would allocate every frame
+	static const string cameraDirectionName("camera_direction");
+	sf::Vector3f camera_direction = state.cameraDirection.asSFML();
+	s.setUniform(cameraDirectionName, (sf::Glsl::Vec3)camera_direction);
 
-	float scale = cam->camera->scale();
-	shader->setUniform("scale", scale);
+	sf::Vector3f camera_up = state.cameraUp.asSFML();
+	s.setUniform("camera_up", (sf::Glsl::Vec3)camera_up);
 
-	float screenWidth = (float)engine->getWindow()->getSize().x;
-	float screenHeight = (float)engine->getWindow()->getSize().y;
-	shader->setUniform("aspect", screenWidth/screenHeight);
-	shader->setUniform("fov", FOV);
+	s.setUniform("scale", state.scale);
+
+	float screenWidth = (float)size.x;
+	float screenHeight = (float)size.y;
+	s.setUniform("aspect", screenWidth/screenHeight);
+	s.setUniform("fov", FOV);
 	
-	shader->setUniform("screen_width", screenWidth);
-	shader->setUniform("screen_height", screenHeight);
+	s.setUniform("screen_width", screenWidth);
+	s.setUniform("screen_height", screenHeight);
 	
-	shader->setUniform("epsilon_factor", EPSILON_FACTOR);
-	shader->setUniform("epsilon_limit", EPSILON_LIMIT);
-	shader->setUniform("max_dist", MAX_DIST);
-	shader->setUniform("max_bailout", MAX_BAILOUT);
-	shader->setUniform("max_iter", MAX_ITER);
-	shader->setUniform("min_iter", MIN_ITER);
-	shader->setUniform("max_steps", MAX_STEPS);
-	shader->setUniform("power", POWER);
+	s.setUniform("epsilon_factor", EPSILON_FACTOR);
+	s.setUniform("epsilon_limit", EPSILON_LIMIT);
+	s.setUniform("max_dist", MAX_DIST);
+	s.setUniform("max_bailout", MAX_BAILOUT);
+	s.setUniform("max_iter", MAX_ITER);
+	s.setUniform("min_iter", MIN_ITER);
+	s.setUniform("max_steps", MAX_STEPS);
+	s.setUniform("power", POWER);
+
+	s.setUniform("fog_enabled", state.fogToggle);
+	s.setUniform("fog_max_dist", FOG_MAX_DIST);
+
+	s.setUniform("glow_dist", GLOW_DIST);
+	s.setUniform("glow_enabled", state.glowToggle);
+
+	s.setUniform("heat_enabled", state.heatToggle);
+
+	// The budgets are per ray, sent every frame like the other knobs
+	static const string shadowMinLightName("shadow_min_light");
+	s.setUniform("shadow_enabled", state.shadowToggle);
+	s.setUniform("light_direction", (sf::Glsl::Vec3)Vector3f::normalize(LIGHT_DIRECTION).asSFML());
+	s.setUniform("shadow_steps", SHADOW_STEPS);
+	s.setUniform("shadow_softness", SHADOW_SOFTNESS);
+	s.setUniform("shadow_distance", SHADOW_DISTANCE);
+	s.setUniform(shadowMinLightName, SHADOW_MIN_LIGHT);
+
+	s.setUniform("ao_enabled", state.aoToggle);
+	s.setUniform("ao_samples", AO_SAMPLES);
+	s.setUniform("ao_radius", AO_RADIUS);
+}
+
+void MandelbulbViewer::draw()
+{
+	countAllocations();
+
+	// Keeps drawing the previous snapshot when the simulation has not ticked
+	ViewState state;
+	sf::Vector2i pending = engine->consumeWithLook([this, &state]{
+		views.consume();
+		state = views.getReadBuffer();
+	});
+
+	// Threaded, mouse look the simulation has not picked up yet is applied to
+	// this frame's copy of the camera only
+	if (engine->isThreadedUpdate() && engine->isLateLatch())
+	{
+		if (pending.x != 0 || pending.y != 0)
+			cam->look(state.cameraDirection, state.cameraUp, pending.x, pending.y);
+	}
+
+	bool warp = !cpuBackend && updateTimewarp(state);
+	if (cpuBackend)
+	{
+		sf::Vector2u size = engine->getWindow()->getSize();
+		cpuRenderer->request(state, sf::Vector2u((unsigned int)(size.x * CPU_RENDER_SCALE), (unsigned int)(size.y * CPU_RENDER_SCALE)));
+	}
+	else if (warp)
+	{
+		marcher->request(state, engine->getWindow()->getSize());
+	}
+	else if (useCompute(state))
+	{
+		resizeComputeTarget();
+		setUniforms(*computeShader, state, engine->getWindow()->getSize());
+	}
+	else
+	{
+		sf::Shader::bind(shader);
+		setUniforms(*shader, state, engine->getWindow()->getSize());
+		sf::Shader::bind(NULL);
+	}
+
+	updateCapture(state);
+	if (state.infoToggle) updateInfo(state);
+
+	gpuTimer->begin(marchPass);
+	if (cpuBackend)
+	{
+		drawCpuFrame();
+	}
+	else if (warp)
+	{
+		drawTimewarp(state);
+	}
+	else if (useCompute(state))
+	{
+		sf::Vector2u size = computeTarget->getSize();
+		computeShader->dispatch(computeTarget->getNativeHandle()
+			, (size.x + COMPUTE_TILE_SIZE - 1) / COMPUTE_TILE_SIZE
+			, (size.y + COMPUTE_TILE_SIZE - 1) / COMPUTE_TILE_SIZE);
+		engine->getWindow()->draw(computeSprite);
+	}
+	else
+	{
+		engine->getWindow()->draw(*quad, shader);
+	}
+	gpuTimer->end(marchPass);
+
+	// Capture before the overlay is drawn on top
+	capture->captureFrame();
+
+	if (state.infoToggle) {
+		gpuTimer->begin(hudPass);
+		engine->getWindow()->draw(infoBg);
+		engine->getWindow()->draw(info);
+		gpuTimer->end(hudPass);
+	}
+
+	gpuTimer->endFrame();
+}
+
+
+// Shows the newest frame the CPU backend finished, scaled to the window
+void MandelbulbViewer::drawCpuFrame()
+{
+	const sf::Texture *frame = cpuRenderer->present();
+	if (frame == nullptr) return;
+
+	sf::Vector2u size = engine->getWindow()->getSize();
+	cpuSprite.setTexture(*frame, true);
+	cpuSprite.setScale((float)size.x / frame->getSize().x, (float)size.y / frame->getSize().y);
+	engine->getWindow()->draw(cpuSprite);
+}
+
+// Starts and stops the async marcher with its toggle, true while its frames are shown
+bool MandelbulbViewer::updateTimewarp(const ViewState &state)
+{
+	if (state.warpToggle && !marcher->isRunning() && warpSupported && !warpFailed)
+	{
+		marcher->start(vertSource, fragSource,
+			[this](sf::Shader &s, const ViewState &view, const sf::Vector2u &size) { setUniforms(s, view, size); });
+	}
+	else if (!state.warpToggle)
+	{
+		warpFailed = false;
+		marcher->stop();
+	}
+
+	if (marcher->isRunning() && marcher->isFailed())
+	{
+		std::cout << "Async march unavailable, timewarp disabled." << std::endl;
+		marcher->stop();
+		warpFailed = true;
+	}
+
+	return marcher->isRunning();
+}
 
-	shader->setUniform("fog_enabled", viewer->fogToggle);
-	shader->setUniform("fog_max_dist", FOG_MAX_DIST);
+// Shows the newest async frame reprojected to the camera of this one
+void MandelbulbViewer::drawTimewarp(const ViewState &state)
+{
+	const AsyncMarcher::Frame *frame = marcher->getFrame();
+	if (frame == nullptr) return;
+
+	float screenWidth = (float)engine->getWindow()->getSize().x;
+	float screenHeight = (float)engine->getWindow()->getSize().y;
 
-	shader->setUniform("glow_dist", GLOW_DIST);
-	shader->setUniform("glow_enabled", viewer->glowToggle);
+	static const string cameraDirectionName("camera_direction");
+	static const string sourceDirectionName("source_direction");
 
-	shader->setUniform("heat_enabled", viewer->heatToggle);
+	sf::Shader::bind(warpShader);
+	warpShader->setUniform("camera_position", (sf::Glsl::Vec3)state.cameraPosition.asSFML());
+	warpShader->setUniform(cameraDirectionName, (sf::Glsl::Vec3)state.cameraDirection.asSFML());
+	warpShader->setUniform("camera_up", (sf::Glsl::Vec3)state.cameraUp.asSFML());
 
+	warpShader->setUniform("source_position", (sf::Glsl::Vec3)frame->view.cameraPosition.asSFML());
+	warpShader->setUniform(sourceDirectionName, (sf::Glsl::Vec3)frame->view.cameraDirection.asSFML());
+	warpShader->setUniform("source_up", (sf::Glsl::Vec3)frame->view.cameraUp.asSFML());
+
+	warpShader->setUniform("aspect", screenWidth/screenHeight);
+	warpShader->setUniform("fov", FOV);
+	warpShader->setUniform("screen_width", screenWidth);
+	warpShader->setUniform("screen_height", screenHeight);
+
+	warpShader->setUniform("color_frame", frame->color->getTexture());
+	warpShader->setUniform("depth_frame", *frame->depth);
 	sf::Shader::bind(NULL);
 
-	if (viewer->infoToggle) updateInfo();
+	engine->getWindow()->draw(*quad, warpShader);
 }
 
-void MandelbulbViewer::draw()
+void MandelbulbViewer::updateCapture(const ViewState &state)
 {
-	engine->getWindow()->draw(*quad, shader);
-	if (viewer->infoToggle) {
-		engine->getWindow()->draw(infoBg);
-		engine->getWindow()->draw(info);
+	sf::Vector2u size = engine->getWindow()->getSize();
+
+	// The PBOs are sized for the window, restart the session when it changes
+	if (capture->isRecording() && (capture->getWidth() != size.x || capture->getHeight() != size.y))
+		capture->stop();
+
+	// The toggle belongs to the simulation thread, a failed start is remembered
+	// here until it is switched off instead of being written back
+	if (state.captureToggle && !capture->isRecording() && !captureFailed)
+	{
+		if (!capture->start(size.x, size.y)) captureFailed = true;
+	}
+	else if (!state.captureToggle)
+	{
+		captureFailed = false;
+		if (capture->isRecording()) capture->stop();
+	}
+}
+
+
+void MandelbulbViewer::updateRecording(const float dt)
+{
+	if (viewer->recordToggle && !recording)
+	{
+		path->clear();
+		recording = true;
+		std::cout << "Recording flythrough" << std::endl;
+	}
+	else if (!viewer->recordToggle && recording)
+	{
+		recording = false;
+		if (path->save(FLYTHROUGH_FILE))
+			std::cout << "Saved " << path->size() << " frames to " << FLYTHROUGH_FILE << std::endl;
+		else
+			std::cout << "Unable to write " << FLYTHROUGH_FILE << std::endl;
+	}
+
+	if (recording) path->add(*cam->camera, cam->getSpeed(), dt);
+}
+
+void MandelbulbViewer::updatePlayback(const float dt)
+{
+	// dt is the wall time of the previous frame, the first one has none
+	if (playbackTime > 0.0f)
+	{
+		playbackFrameTimes->addFrame(dt);
+		playbackGpuTimes->addFrame(engine->getFrameStats().getPassTime(marchPass));
+		playbackAllocations += frameAllocations;
+		playbackMaxAllocations = max(playbackMaxAllocations, frameAllocations);
+	}
+
+	if (playbackTime > path->getDuration())
+	{
+		printPlaybackReport();
+		playing = false;
+		engine->stop();
+		return;
+	}
+
+	// Simulated time advances by a fixed step, every run renders the same frames
+	float speed = cam->getSpeed();
+	path->sample(playbackTime, *cam->camera, speed);
+	cam->setSpeed(speed);
+	playbackTime += PLAYBACK_TIMESTEP;
+}
+
+void MandelbulbViewer::printPlaybackReport() const
+{
+	const FrameStats &f = *playbackFrameTimes;
+	const FrameStats &g = *playbackGpuTimes;
+	float wall = f.getMeanFrameTime() * f.getFrameCount();
+
+	std::cout << "Frame time report" << std::endl
+		<< "  frames:    " << f.getFrameCount() << std::endl
+		<< "  wall time: " << wall << " s" << std::endl
+		<< "  mean fps:  " << (wall > 0.0f ? f.getFrameCount() / wall : 0.0f) << std::endl
+		<< "  mean:      " << f.getMeanFrameTime() * 1000.0f << " ms" << std::endl
+		<< "  min:       " << f.getPercentileFrameTime(0.0f) * 1000.0f << " ms" << std::endl
+		<< "  p50:       " << f.getPercentileFrameTime(0.5f) * 1000.0f << " ms" << std::endl
+		<< "  p95:       " << f.getPercentileFrameTime(0.95f) * 1000.0f << " ms" << std::endl
+		<< "  p99:       " << f.getPercentileFrameTime(0.99f) * 1000.0f << " ms" << std::endl
+		<< "  max:       " << f.getPercentileFrameTime(1.0f) * 1000.0f << " ms" << std::endl
+		<< "  gpu march: " << g.getMeanFrameTime() << " ms mean, "
+		<< g.getPercentileFrameTime(0.99f) << " ms p99" << std::endl;
+
+	if (AllocTracker::isEnabled())
+	{
+		std::cout << "  heap:      " << (double)playbackAllocations / max(1, f.getFrameCount()) << " allocations per frame, "
+			<< playbackMaxAllocations << " max" << std::endl;
+	}
+}
+
+// At the start of every frame, what all threads allocated since the last one
+void MandelbulbViewer::countAllocations()
+{
+	if (!AllocTracker::isEnabled()) return;
+
+	AllocTracker::Counts now = AllocTracker::total();
+	frameAllocations = now.allocations - lastAllocations.allocations;
+	frameAllocatedBytes = now.bytes - lastAllocations.bytes;
+	lastAllocations = now;
+
+	// Only call sites from the steady state are reported
+	if (++allocFrames == ALLOC_WARMUP_FRAMES) AllocTracker::resetSites();
+	if (allocFrames <= ALLOC_WARMUP_FRAMES || frameAllocations == 0) return;
+
+	if (++allocatingFrames == 1 && steadyState)
+	{
+		std::cout << "Steady state broken: frame " << allocFrames << " allocated "
+			<< frameAllocations << " times" << std::endl;
+	}
+}
+
+int MandelbulbViewer::reportSteadyState() const
+{
+	if (allocFrames <= ALLOC_WARMUP_FRAMES)
+	{
+		std::cout << "Steady state unchecked, only " << allocFrames << " of "
+			<< ALLOC_WARMUP_FRAMES << " warm-up frames were drawn" << std::endl;
+		return EXIT_FAILURE;
 	}
+
+	if (allocatingFrames == 0)
+	{
+		std::cout << "Steady state held: no allocations in " << allocFrames - ALLOC_WARMUP_FRAMES << " frames" << std::endl;
+		return EXIT_SUCCESS;
+	}
+
+	std::cout << "Steady state broken: " << allocatingFrames << " of " << allocFrames - ALLOC_WARMUP_FRAMES
+		<< " frames allocated" << std::endl;
+	AllocTracker::printSites(std::cout, ALLOC_REPORT_SITES);
+	return EXIT_FAILURE;
 }
 
 
 float lerp(float a, float b, float f) { return a + f * (b - a); }
 
-void MandelbulbViewer::updateInfo()
+void MandelbulbViewer::updateInfo(const ViewState &state)
 {
-	stringstream ss; 
+	infoText.clear();
 
 	float fps = engine->getFPS();
-	ss << "fps: " << fps << endl;
+	infoText.append("fps: %g\n", fps);
+	if (cpuBackend)
+	{
+		infoText.append("path: cpu, %d threads\n", cpuRenderer->getThreadCount());
+		infoText.append("cpu frame: %g ms\n", cpuRenderer->getFrameTime());
+		infoText.append("tiles cancelled: %d, reused: %d\n", cpuRenderer->getCancelledTiles(), cpuRenderer->getReusedTiles());
+		infoText.append("frames superseded: %d\n", cpuRenderer->getSupersededFrames());
+		infoText.append("speculation: %d hits, %d misses\n", cpuRenderer->getSpeculationHits(), cpuRenderer->getSpeculationMisses());
+	}
+	else if (marcher->isRunning())
+	{
+		infoText.append("path: timewarp\n");
+		infoText.append("async march: %g ms\n", marcher->getFrameTime());
+	}
+	else
+	{
+		infoText.append("path: %s\n", useCompute(state) ? "compute" : "fragment");
+	}
 
-	float speed = cam->getSpeed();
-	ss << "speed: " << speed << endl;
+	const FrameStats &stats = engine->getFrameStats();
+	for (int i = 0; i < stats.getPassCount(); ++i)
+	{
+		infoText.append("gpu %s: %g ms\n", stats.getPassName(i).c_str(), stats.getPassTime(i));
+	}
 
-	
-	float mindist = cam->camera->estimateMandelbulbDistance();
-	ss << "mindist: " << mindist << endl;
+	const FrameStats &latency = engine->getLatencyTracker().getStats();
+	infoText.append("input latency: %g ms mean, %g ms p99%s\n", latency.getMeanFrameTime() * 1000.0f,
+		latency.getPercentileFrameTime(0.99f) * 1000.0f, engine->isLateLatch() ? " (late latch)" : "");
 
-	float scale = cam->camera->scale();
-	ss << "scale: " << scale << endl;
-	ss << "1/scale: " << 1.0f/scale << endl;
-	ss << "pow(scale, 2): " << pow(scale, 2) << endl;
+	if (AllocTracker::isEnabled())
+	{
+		infoText.append("heap: %lld allocations, %lld bytes last frame\n", frameAllocations, frameAllocatedBytes);
+		infoText.append("frames allocating after warm-up: %d\n", allocatingFrames);
+	}
+
+	infoText.append("speed: %g\n", state.speed);
+
+	infoText.append("mindist: %g\n", state.mindist);
+
+	float scale = state.scale;
+	infoText.append("scale: %g\n", scale);
+	infoText.append("1/scale: %g\n", 1.0f/scale);
+	infoText.append("pow(scale, 2): %g\n", pow(scale, 2));
 
 	float epsilon = EPSILON_FACTOR * scale;
-	ss << "epsilon: " << epsilon << endl;
+	infoText.append("epsilon: %g\n", epsilon);
 
 	float viewlimit = MAX_DIST * scale;
-	ss << "viewlimit: " << viewlimit << endl;
+	infoText.append("viewlimit: %g\n", viewlimit);
 
 	//float curr_max_iter = lerp(MIN_ITER, MAX_ITER, 1.0 - scale);
-	//ss << "curr_max_iter: " << curr_max_iter << endl;
+	//infoText.append("curr_max_iter: %g\n", curr_max_iter);
 
 	//float max_bailout = MAX_BAILOUT * scale;
-	//ss << "max_bailout: " << max_bailout << endl;
+	//infoText.append("max_bailout: %g\n", max_bailout);
 
-	info.setString(ss.str());
+	info.setString(infoText.getString());
 	infoBg.setSize(sf::Vector2f(info.getGlobalBounds().width, info.getGlobalBounds().height));
 }
 
-
 MandelbulbViewer::ViewerInputListener::ViewerInputListener()
 	: infoToggle(false)
 	, fogToggle(FOG_ENABLED)
 	, glowToggle(GLOW_ENABLED)
 	, heatToggle(HEAT_ENABLED)
+	, shadowToggle(SHADOWS_ENABLED)
+	, aoToggle(AO_ENABLED)
+	, captureToggle(false)
+	, computeToggle(false)
+	, recordToggle(false)
+	, latchToggle(LATE_LATCH_INPUT)
+	, warpToggle(false)
 {}
 
 void MandelbulbViewer::ViewerInputListener::update(const float dt) {}
@@ -199,6 +793,13 @@ void MandelbulbViewer::ViewerInputListener::keyPressed(const sf::Keyboard::Key &
 	if (key == sf::Keyboard::Num1) fogToggle = !fogToggle;
 	if (key == sf::Keyboard::Num2) glowToggle = !glowToggle;
 	if (key == sf::Keyboard::Num3) heatToggle = !heatToggle;
+	if (key == sf::Keyboard::Num4) shadowToggle = !shadowToggle;
+	if (key == sf::Keyboard::Num5) aoToggle = !aoToggle;
+	if (key == sf::Keyboard::C) captureToggle = !captureToggle;
+	if (key == sf::Keyboard::G) computeToggle = !computeToggle;
+	if (key == sf::Keyboard::R) recordToggle = !recordToggle;
+	if (key == sf::Keyboard::L) latchToggle = !latchToggle;
+	if (key == sf::Keyboard::T) warpToggle = !warpToggle;
 }
 
 void MandelbulbViewer::ViewerInputListener::keyHeld(const sf::Keyboard::Key &key, const float dt) {}
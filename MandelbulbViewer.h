@@ -4,6 +4,16 @@
 #include "Engine.h"
 #include "CameraController.h"
 #include "InputListener.h"
+#include "GpuTimer.h"
+#include "FrameCapture.h"
+#include "ComputeShader.h"
+#include "CameraPath.h"
+#include "TripleBuffer.h"
+#include "ViewState.h"
+#include "AsyncMarcher.h"
+#include "CpuRenderer.h"
+#include "AllocTracker.h"
+#include "InfoText.h"
 #include <SFML/Graphics/Shader.hpp>
 #include <SFML/Graphics/Text.hpp>
 
@@ -15,6 +25,19 @@ public:
 
 	int run();
 
+	// Renders on CPU threads even when the GPU backend is available
+	void setCpuBackend(const bool &cpu);
+
+	// Renders one frame with the fragment and the compute path and compares them
+	int verifyCompute();
+
+	// Flies the recorded path at a fixed timestep and prints a frame time report
+	int playback(const string &filename);
+
+	// Tracks heap allocations, and run() and playback() fail if any frame
+	// after ALLOC_WARMUP_FRAMES allocated
+	void setSteadyState(const bool &steady);
+
 private:
 	class ViewerInputListener : public InputListener
 	{
@@ -23,6 +46,13 @@ private:
 		bool fogToggle;
 		bool glowToggle;
 		bool heatToggle;
+		bool shadowToggle;
+		bool aoToggle;
+		bool captureToggle;
+		bool computeToggle;
+		bool recordToggle;
+		bool latchToggle;
+		bool warpToggle;
 
 		ViewerInputListener();
 
@@ -44,17 +74,80 @@ private:
 	ViewerInputListener *viewer;
 	CameraController *cam;
 	sf::Shader *shader;
+	string vertSource;
+	string fragSource;
 	sf::RectangleShape *quad;
 	sf::Font infoFont;
 	sf::Text info;
+	InfoText infoText;
 	sf::RectangleShape infoBg;
 
+	GpuTimer *gpuTimer;
+	int marchPass;
+	int hudPass;
+
+	FrameCapture *capture;
+
+	ComputeShader *computeShader;
+	sf::Texture *computeTarget;
+	sf::Sprite computeSprite;
+	bool computeSupported;
+
+	AsyncMarcher *marcher;
+	sf::Shader *warpShader;
+	bool warpSupported;
+	bool warpFailed;
+
+	bool cpuBackend;
+	CpuRenderer *cpuRenderer;
+	sf::Sprite cpuSprite;
+
+	TripleBuffer<ViewState> views;
+	float mindist;
+	bool captureFailed;
+
+	CameraPath *path;
+	bool recording;
+	bool playing;
+	float playbackTime;
+	FrameStats *playbackFrameTimes;
+	FrameStats *playbackGpuTimes;
+
+	bool steadyState;
+	AllocTracker::Counts lastAllocations;
+	long long frameAllocations;
+	long long frameAllocatedBytes;
+	int allocFrames;
+	int allocatingFrames;
+	long long playbackAllocations;
+	long long playbackMaxAllocations;
+
 	void init();
+	bool initShaders();
 	void preupdate();
 	void update(const float dt);
 	void draw();
 
-	void updateInfo();
+	void initCompute();
+	void resizeComputeTarget();
+	bool useCompute(const ViewState &state) const;
+
+	bool updateTimewarp(const ViewState &state);
+	void drawTimewarp(const ViewState &state);
+	void drawCpuFrame();
+
+	void publishState();
+
+	template <typename S>
+	void setUniforms(S &s, const ViewState &state, const sf::Vector2u &size);
+
+	void updateInfo(const ViewState &state);
+	void countAllocations();
+	int reportSteadyState() const;
+	void updateCapture(const ViewState &state);
+	void updateRecording(const float dt);
+	void updatePlayback(const float dt);
+	void printPlaybackReport() const;
 
 	
 };
@@ -1,96 +1,21 @@
+// Enable constants like PI, before the header pulls in cmath
+#define _USE_MATH_DEFINES
 #include "Matrix4.h"
 
 #include "Vector3f.h"
 #include "Quaternion.h"
 
-// Enable constants like PI
-#define _USE_MATH_DEFINES
 #include <cmath>
-#include <cstring>
 #include <cstdlib>
 #include <iostream>
 
 using namespace std;
 
-Matrix4::Matrix4()
-{
-	val[M00] = 1.f; val[M01] = 0.f; val[M02]  = 0.f; val[M03] = 0.f;
-    val[M10] = 0.f; val[M11] = 1.f; val[M12]  = 0.f; val[M13] = 0.f;
-    val[M20] = 0.f; val[M21] = 0.f; val[M22]  = 1.f; val[M23] = 0.f;
-    val[M30] = 0.f; val[M31] = 0.f; val[M32]  = 0.f; val[M33] = 1.f;
-}
-
-Matrix4::Matrix4(const Matrix4 &other)
-{
-	memcpy(val, other.val, 16*sizeof(float));
-}
-
-Matrix4::Matrix4(Matrix4 &&other)
-{
-	memcpy(val, other.val, 16*sizeof(float));
-}
-
-Matrix4& Matrix4::set(const Matrix4& other)
-{
-	memcpy(val, other.val, 16*sizeof(float));
-	return *this;
-}
-
-const float* Matrix4::asArray() const
-{
-	return val;
-}
-
-
-Matrix4& Matrix4::identity()
-{
-	val[M00] = 1.0f; val[M01] = 0.0f; val[M02] = 0.0f; val[M03] = 0.0f;
-	val[M10] = 0.0f; val[M11] = 1.0f; val[M12] = 0.0f; val[M13] = 0.0f;
-	val[M20] = 0.0f; val[M21] = 0.0f; val[M22] = 1.0f; val[M23] = 0.0f;
-	val[M30] = 0.0f; val[M31] = 0.0f; val[M32] = 0.0f; val[M33] = 1.0f;
-	return *this;
-}
-
 Matrix4& Matrix4::set (const Quaternion &quat)
 {
 	return this->set(quat.x, quat.y, quat.z, quat.w);
 }
 
-Matrix4& Matrix4::set (const float &quaternionX, const float &quaternionY, const float &quaternionZ, const float &quaternionW)
-{
-	return this->set(0.0f, 0.0f, 0.0f, quaternionX, quaternionY, quaternionZ, quaternionW);
-}
-
-Matrix4& Matrix4::set ( const float &translationX, const float &translationY, const float &translationZ
-		              , const float &quaternionX, const float &quaternionY, const float &quaternionZ, const float &quaternionW)
-{
-	const float xs = quaternionX * 2.0f, ys = quaternionY * 2.0f, zs = quaternionZ * 2.0f;
-	const float wx = quaternionW * xs  , wy = quaternionW * ys  , wz = quaternionW * zs;
-	const float xx = quaternionX * xs  , xy = quaternionX * ys  , xz = quaternionX * zs;
-	const float yy = quaternionY * ys  , yz = quaternionY * zs  , zz = quaternionZ * zs;
-
-	val[M00] = (1.0f - (yy + zz));
-	val[M01] = (xy - wz);
-	val[M02] = (xz + wy);
-	val[M03] = translationX;
-
-	val[M10] = (xy + wz);
-	val[M11] = (1.0f - (xx + zz));
-	val[M12] = (yz - wx);
-	val[M13] = translationY;
-
-	val[M20] = (xz - wy);
-	val[M21] = (yz + wx);
-	val[M22] = (1.0f - (xx + yy));
-	val[M23] = translationZ;
-
-	val[M30] = 0.0f;
-	val[M31] = 0.0f;
-	val[M32] = 0.0f;
-	val[M33] = 1.0f;
-	return *this;
-}
-
 Matrix4& Matrix4::setToProjection(float near, float far, float fovy, float aspectRatio)
 {
 	identity();
@@ -118,24 +43,6 @@ Matrix4& Matrix4::setToProjection(float near, float far, float fovy, float aspec
 	return *this;
 }
 
-Matrix4& Matrix4::setToTranslation (const Vector3f &v)
-{
-	identity();
-	val[M03] = v.x;
-	val[M13] = v.y;
-	val[M23] = v.z;
-	return *this;
-}
-
-Matrix4& Matrix4::setToTranslation (float x, float y, float z)
-{
-	identity();
-	val[M03] = x;
-	val[M13] = y;
-	val[M23] = z;
-	return *this;
-}
-
 Matrix4& Matrix4::setToRotation (const float &axisX, const float &axisY, const float &axisZ, const float &degrees)
 {
 
@@ -189,6 +96,13 @@ Matrix4& Matrix4::setToLookAt (Vector3f position, Vector3f target, Vector3f up)
 	return *this;
 }
 
+void Matrix4::singular()
+{
+	cout << "Non-invertible matrix inverted!" << endl;
+	exit(EXIT_FAILURE);
+}
+
+#ifndef MATRIX4_SSE
 
 Matrix4& Matrix4::inv()
 {
@@ -201,10 +115,7 @@ Matrix4& Matrix4::inv()
 			* val[M01] * val[M32] * val[M23] - val[M00] * val[M11] * val[M32] * val[M23] - val[M20] * val[M11] * val[M02] * val[M33]
 			+ val[M10] * val[M21] * val[M02] * val[M33] + val[M20] * val[M01] * val[M12] * val[M33] - val[M00] * val[M21] * val[M12]
 			* val[M33] - val[M10] * val[M01] * val[M22] * val[M33] + val[M00] * val[M11] * val[M22] * val[M33];
-	if (l_det == 0.0f) {
-		cout << "Non-invertible matrix inverted!" << endl;
-		exit(EXIT_FAILURE);
-	}
+	if (l_det == 0.0f) singular();
 	
 	float inv_det = 1.0f / l_det;
 	float tmp[16];
@@ -260,69 +171,4 @@ Matrix4& Matrix4::inv()
 	return *this;
 }
 
-
-
-Matrix4& Matrix4::add(const Matrix4 &other)
-{
-	*this += other;
-	return *this;
-}
-
-Matrix4& Matrix4::mul(const Matrix4 &other)
-{
-	*this *= other;
-	return *this;
-}
-
-Matrix4& Matrix4::operator+=(const Matrix4 &other)
-{
-	const float *otherVal = other.val;
-
-	val[M00] += otherVal[M00];
-	val[M01] += otherVal[M01];
-	val[M02] += otherVal[M02];
-	val[M03] += otherVal[M03];
-	val[M10] += otherVal[M10];
-	val[M11] += otherVal[M11];
-	val[M12] += otherVal[M12];
-	val[M13] += otherVal[M13];
-	val[M20] += otherVal[M20];
-	val[M21] += otherVal[M21];
-	val[M22] += otherVal[M22];
-	val[M23] += otherVal[M23];
-	val[M30] += otherVal[M30];
-	val[M31] += otherVal[M31];
-	val[M32] += otherVal[M32];
-	val[M33] += otherVal[M33];
-	
-	return *this;
-}
-
-
-Matrix4& Matrix4::operator*=(const Matrix4 &other)
-{
-	float tmpVal[16];
-
-	const float *otherVal = other.val;
-
-	memcpy(tmpVal, val, 16*sizeof(float));
-
-	val[M00] = tmpVal[M00]*otherVal[M00] + tmpVal[M01]*otherVal[M10] + tmpVal[M02]*otherVal[M20]  + tmpVal[M03]*otherVal[M30];
-	val[M01] = tmpVal[M00]*otherVal[M01] + tmpVal[M01]*otherVal[M11] + tmpVal[M02]*otherVal[M21]  + tmpVal[M03]*otherVal[M31];
-	val[M02] = tmpVal[M00]*otherVal[M02] + tmpVal[M01]*otherVal[M12] + tmpVal[M02]*otherVal[M22]  + tmpVal[M03]*otherVal[M32];
-	val[M03] = tmpVal[M00]*otherVal[M03] + tmpVal[M01]*otherVal[M13] + tmpVal[M02]*otherVal[M23]  + tmpVal[M03]*otherVal[M33];
-	val[M10] = tmpVal[M10]*otherVal[M00] + tmpVal[M11]*otherVal[M10] + tmpVal[M12]*otherVal[M20]  + tmpVal[M13]*otherVal[M30];
-	val[M11] = tmpVal[M10]*otherVal[M01] + tmpVal[M11]*otherVal[M11] + tmpVal[M12]*otherVal[M21]  + tmpVal[M13]*otherVal[M31];
-	val[M12] = tmpVal[M10]*otherVal[M02] + tmpVal[M11]*otherVal[M12] + tmpVal[M12]*otherVal[M22]  + tmpVal[M13]*otherVal[M32];
-	val[M13] = tmpVal[M10]*otherVal[M03] + tmpVal[M11]*otherVal[M13] + tmpVal[M12]*otherVal[M23]  + tmpVal[M13]*otherVal[M33];
-	val[M20] = tmpVal[M20]*otherVal[M00] + tmpVal[M21]*otherVal[M10] + tmpVal[M22]*otherVal[M20]  + tmpVal[M23]*otherVal[M30];
-	val[M21] = tmpVal[M20]*otherVal[M01] + tmpVal[M21]*otherVal[M11] + tmpVal[M22]*otherVal[M21]  + tmpVal[M23]*otherVal[M31];
-	val[M22] = tmpVal[M20]*otherVal[M02] + tmpVal[M21]*otherVal[M12] + tmpVal[M22]*otherVal[M22]  + tmpVal[M23]*otherVal[M32];
-	val[M23] = tmpVal[M20]*otherVal[M03] + tmpVal[M21]*otherVal[M13] + tmpVal[M22]*otherVal[M23]  + tmpVal[M23]*otherVal[M33];
-	val[M30] = tmpVal[M30]*otherVal[M00] + tmpVal[M31]*otherVal[M10] + tmpVal[M32]*otherVal[M20]  + tmpVal[M33]*otherVal[M30];
-	val[M31] = tmpVal[M30]*otherVal[M01] + tmpVal[M31]*otherVal[M11] + tmpVal[M32]*otherVal[M21]  + tmpVal[M33]*otherVal[M31];
-	val[M32] = tmpVal[M30]*otherVal[M02] + tmpVal[M31]*otherVal[M12] + tmpVal[M32]*otherVal[M22]  + tmpVal[M33]*otherVal[M32];
-	val[M33] = tmpVal[M30]*otherVal[M03] + tmpVal[M31]*otherVal[M13] + tmpVal[M32]*otherVal[M23]  + tmpVal[M33]*otherVal[M33];
-	
-	return *this;
-}
+#endif /* MATRIX4_SSE */
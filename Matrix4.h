@@ -1,15 +1,31 @@
 #ifndef MATRIX_4_H
 #define MATRIX_4_H
 
-class Vector3f;
+#include <cstddef>
+#include <cstring>
+
+#include "Vector3f.h"
+
+// x64 always has SSE2, 32 bit builds when /arch:SSE2 or -msse2 says so
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define MATRIX4_SSE
+#include <xmmintrin.h>
+#endif
+
 class Quaternion;
 
+/*
+ * Column major, see the Mxy indices below. Multiply, inverse and the batch
+ * transforms are inline and use SSE where the target has it, the setup
+ * helpers that need trigonometry or a Quaternion stay in the .cpp.
+ */
 class Matrix4
 {
 public:
 	Matrix4();
-	Matrix4(const Matrix4 &other);
-	Matrix4(Matrix4 &&other);
+	Matrix4(const Matrix4 &other) = default;
+	Matrix4(Matrix4 &&other) = default;
+	Matrix4& operator=(const Matrix4 &other) = default;
 
 	Matrix4& set(const Matrix4& other);
 	const float* asArray() const;
@@ -41,9 +57,16 @@ public:
 	Matrix4& operator+=(const Matrix4 &other);
 	Matrix4& operator*=(const Matrix4 &other);
 
+	// Vector3f::mul and Vector3f::rot over arrays, in and out may be the same
+	void transformPoints(const Vector3f *in, Vector3f *out, const size_t &count) const;
+	void rotateVectors(const Vector3f *in, Vector3f *out, const size_t &count) const;
+
 private:
 	float val[16];
 
+	// Prints and exits, like inverting a singular matrix always has
+	static void singular();
+
 public:
 	static const int M00 = 0;
 	static const int M01 = 4;
@@ -63,4 +86,276 @@ public:
 	static const int M33 = 15;
 };
 
-#endif /* MATRIX_4_H */
\ No newline at end of file
+inline Matrix4::Matrix4()
+{
+	identity();
+}
+
+inline Matrix4& Matrix4::set(const Matrix4& other)
+{
+	memcpy(val, other.val, 16*sizeof(float));
+	return *this;
+}
+
+inline const float* Matrix4::asArray() const
+{
+	return val;
+}
+
+inline Matrix4& Matrix4::identity()
+{
+	val[M00] = 1.0f; val[M01] = 0.0f; val[M02] = 0.0f; val[M03] = 0.0f;
+	val[M10] = 0.0f; val[M11] = 1.0f; val[M12] = 0.0f; val[M13] = 0.0f;
+	val[M20] = 0.0f; val[M21] = 0.0f; val[M22] = 1.0f; val[M23] = 0.0f;
+	val[M30] = 0.0f; val[M31] = 0.0f; val[M32] = 0.0f; val[M33] = 1.0f;
+	return *this;
+}
+
+inline Matrix4& Matrix4::set (const float &quaternionX, const float &quaternionY, const float &quaternionZ, const float &quaternionW)
+{
+	return this->set(0.0f, 0.0f, 0.0f, quaternionX, quaternionY, quaternionZ, quaternionW);
+}
+
+inline Matrix4& Matrix4::set ( const float &translationX, const float &translationY, const float &translationZ
+		                     , const float &quaternionX, const float &quaternionY, const float &quaternionZ, const float &quaternionW)
+{
+	const float xs = quaternionX * 2.0f, ys = quaternionY * 2.0f, zs = quaternionZ * 2.0f;
+	const float wx = quaternionW * xs  , wy = quaternionW * ys  , wz = quaternionW * zs;
+	const float xx = quaternionX * xs  , xy = quaternionX * ys  , xz = quaternionX * zs;
+	const float yy = quaternionY * ys  , yz = quaternionY * zs  , zz = quaternionZ * zs;
+
+	val[M00] = (1.0f - (yy + zz));
+	val[M01] = (xy - wz);
+	val[M02] = (xz + wy);
+	val[M03] = translationX;
+
+	val[M10] = (xy + wz);
+	val[M11] = (1.0f - (xx + zz));
+	val[M12] = (yz - wx);
+	val[M13] = translationY;
+
+	val[M20] = (xz - wy);
+	val[M21] = (yz + wx);
+	val[M22] = (1.0f - (xx + yy));
+	val[M23] = translationZ;
+
+	val[M30] = 0.0f;
+	val[M31] = 0.0f;
+	val[M32] = 0.0f;
+	val[M33] = 1.0f;
+	return *this;
+}
+
+inline Matrix4& Matrix4::setToTranslation (const Vector3f &v)
+{
+	return setToTranslation(v.x, v.y, v.z);
+}
+
+inline Matrix4& Matrix4::setToTranslation (float x, float y, float z)
+{
+	identity();
+	val[M03] = x;
+	val[M13] = y;
+	val[M23] = z;
+	return *this;
+}
+
+inline Matrix4& Matrix4::add(const Matrix4 &other)
+{
+	return *this += other;
+}
+
+inline Matrix4& Matrix4::mul(const Matrix4 &other)
+{
+	return *this *= other;
+}
+
+inline Matrix4& Matrix4::operator+=(const Matrix4 &other)
+{
+	for (int i = 0; i < 16; ++i) val[i] += other.val[i];
+	return *this;
+}
+
+#ifdef MATRIX4_SSE
+
+// Column c of the product is this times column c of other, a sum of the
+// columns of this scaled by the entries of that column
+inline Matrix4& Matrix4::operator*=(const Matrix4 &other)
+{
+	const __m128 a0 = _mm_loadu_ps(val + 0);
+	const __m128 a1 = _mm_loadu_ps(val + 4);
+	const __m128 a2 = _mm_loadu_ps(val + 8);
+	const __m128 a3 = _mm_loadu_ps(val + 12);
+
+	for (int c = 0; c < 4; ++c)
+	{
+		const float *b = other.val + c * 4;
+		__m128 r = _mm_mul_ps(a0, _mm_set1_ps(b[0]));
+		r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(b[1])));
+		r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(b[2])));
+		r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(b[3])));
+		_mm_storeu_ps(val + c * 4, r);
+	}
+
+	return *this;
+}
+
+// 2x2 blocks held row major in one register: a b / c d as (a, b, c, d)
+#define MATRIX4_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+#define MATRIX4_SWIZZLE(a, x, y, z, w) MATRIX4_SHUFFLE(a, a, x, y, z, w)
+
+// A B
+inline __m128 matrix4Mul2(const __m128 &a, const __m128 &b)
+{
+	return _mm_add_ps(_mm_mul_ps(a, MATRIX4_SWIZZLE(b, 0, 3, 0, 3)),
+	                  _mm_mul_ps(MATRIX4_SWIZZLE(a, 1, 0, 3, 2), MATRIX4_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// adj(A) B
+inline __m128 matrix4AdjMul2(const __m128 &a, const __m128 &b)
+{
+	return _mm_sub_ps(_mm_mul_ps(MATRIX4_SWIZZLE(a, 3, 3, 0, 0), b),
+	                  _mm_mul_ps(MATRIX4_SWIZZLE(a, 1, 1, 2, 2), MATRIX4_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+// A adj(B)
+inline __m128 matrix4MulAdj2(const __m128 &a, const __m128 &b)
+{
+	return _mm_sub_ps(_mm_mul_ps(a, MATRIX4_SWIZZLE(b, 3, 0, 3, 0)),
+	                  _mm_mul_ps(MATRIX4_SWIZZLE(a, 1, 0, 3, 2), MATRIX4_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// Blockwise inverse from the 2x2 sub matrices and their adjugates. The
+// columns are loaded as rows, which inverts the transpose, and stored back
+// as columns, which transposes it again.
+inline Matrix4& Matrix4::inv()
+{
+	const __m128 r0 = _mm_loadu_ps(val + 0);
+	const __m128 r1 = _mm_loadu_ps(val + 4);
+	const __m128 r2 = _mm_loadu_ps(val + 8);
+	const __m128 r3 = _mm_loadu_ps(val + 12);
+
+	const __m128 a = _mm_movelh_ps(r0, r1);
+	const __m128 b = _mm_movehl_ps(r1, r0);
+	const __m128 c = _mm_movelh_ps(r2, r3);
+	const __m128 d = _mm_movehl_ps(r3, r2);
+
+	// (|A|, |B|, |C|, |D|)
+	const __m128 detSub = _mm_sub_ps(
+		_mm_mul_ps(MATRIX4_SHUFFLE(r0, r2, 0, 2, 0, 2), MATRIX4_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+		_mm_mul_ps(MATRIX4_SHUFFLE(r0, r2, 1, 3, 1, 3), MATRIX4_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+	const __m128 detA = MATRIX4_SWIZZLE(detSub, 0, 0, 0, 0);
+	const __m128 detB = MATRIX4_SWIZZLE(detSub, 1, 1, 1, 1);
+	const __m128 detC = MATRIX4_SWIZZLE(detSub, 2, 2, 2, 2);
+	const __m128 detD = MATRIX4_SWIZZLE(detSub, 3, 3, 3, 3);
+
+	const __m128 dc = matrix4AdjMul2(d, c);
+	const __m128 ab = matrix4AdjMul2(a, b);
+	__m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), matrix4Mul2(b, dc));
+	__m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), matrix4Mul2(c, ab));
+	__m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), matrix4MulAdj2(d, ab));
+	__m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), matrix4MulAdj2(a, dc));
+
+	// |M| = |A||D| + |B||C| - tr(adj(A) B adj(D) C)
+	__m128 tr = _mm_mul_ps(ab, MATRIX4_SWIZZLE(dc, 0, 2, 1, 3));
+	tr = _mm_add_ps(tr, _mm_movehl_ps(tr, tr));
+	tr = _mm_add_ss(tr, MATRIX4_SWIZZLE(tr, 1, 1, 1, 1));
+	__m128 det = _mm_sub_ss(_mm_add_ss(_mm_mul_ss(detA, detD), _mm_mul_ss(detB, detC)), tr);
+
+	if (_mm_cvtss_f32(det) == 0.0f) singular();
+
+	const __m128 rDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), MATRIX4_SWIZZLE(det, 0, 0, 0, 0));
+	x = _mm_mul_ps(x, rDet);
+	y = _mm_mul_ps(y, rDet);
+	z = _mm_mul_ps(z, rDet);
+	w = _mm_mul_ps(w, rDet);
+
+	_mm_storeu_ps(val + 0, MATRIX4_SHUFFLE(x, y, 3, 1, 3, 1));
+	_mm_storeu_ps(val + 4, MATRIX4_SHUFFLE(x, y, 2, 0, 2, 0));
+	_mm_storeu_ps(val + 8, MATRIX4_SHUFFLE(z, w, 3, 1, 3, 1));
+	_mm_storeu_ps(val + 12, MATRIX4_SHUFFLE(z, w, 2, 0, 2, 0));
+	return *this;
+}
+
+#undef MATRIX4_SWIZZLE
+#undef MATRIX4_SHUFFLE
+
+// Four points at a time as x, y and z registers, the columns broadcast once
+inline void Matrix4::transformPoints(const Vector3f *in, Vector3f *out, const size_t &count) const
+{
+	const __m128 m00 = _mm_set1_ps(val[M00]), m01 = _mm_set1_ps(val[M01]), m02 = _mm_set1_ps(val[M02]), m03 = _mm_set1_ps(val[M03]);
+	const __m128 m10 = _mm_set1_ps(val[M10]), m11 = _mm_set1_ps(val[M11]), m12 = _mm_set1_ps(val[M12]), m13 = _mm_set1_ps(val[M13]);
+	const __m128 m20 = _mm_set1_ps(val[M20]), m21 = _mm_set1_ps(val[M21]), m22 = _mm_set1_ps(val[M22]), m23 = _mm_set1_ps(val[M23]);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 x = _mm_setr_ps(in[i].x, in[i + 1].x, in[i + 2].x, in[i + 3].x);
+		const __m128 y = _mm_setr_ps(in[i].y, in[i + 1].y, in[i + 2].y, in[i + 3].y);
+		const __m128 z = _mm_setr_ps(in[i].z, in[i + 1].z, in[i + 2].z, in[i + 3].z);
+
+		float rx[4], ry[4], rz[4];
+		_mm_storeu_ps(rx, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m01)), _mm_add_ps(_mm_mul_ps(z, m02), m03)));
+		_mm_storeu_ps(ry, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m10), _mm_mul_ps(y, m11)), _mm_add_ps(_mm_mul_ps(z, m12), m13)));
+		_mm_storeu_ps(rz, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m20), _mm_mul_ps(y, m21)), _mm_add_ps(_mm_mul_ps(z, m22), m23)));
+		for (int j = 0; j < 4; ++j) out[i + j].set(rx[j], ry[j], rz[j]);
+	}
+
+	for (; i < count; ++i) out[i] = Vector3f(in[i]).mul(*this);
+}
+
+inline void Matrix4::rotateVectors(const Vector3f *in, Vector3f *out, const size_t &count) const
+{
+	const __m128 m00 = _mm_set1_ps(val[M00]), m01 = _mm_set1_ps(val[M01]), m02 = _mm_set1_ps(val[M02]);
+	const __m128 m10 = _mm_set1_ps(val[M10]), m11 = _mm_set1_ps(val[M11]), m12 = _mm_set1_ps(val[M12]);
+	const __m128 m20 = _mm_set1_ps(val[M20]), m21 = _mm_set1_ps(val[M21]), m22 = _mm_set1_ps(val[M22]);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 x = _mm_setr_ps(in[i].x, in[i + 1].x, in[i + 2].x, in[i + 3].x);
+		const __m128 y = _mm_setr_ps(in[i].y, in[i + 1].y, in[i + 2].y, in[i + 3].y);
+		const __m128 z = _mm_setr_ps(in[i].z, in[i + 1].z, in[i + 2].z, in[i + 3].z);
+
+		float rx[4], ry[4], rz[4];
+		_mm_storeu_ps(rx, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m01)), _mm_mul_ps(z, m02)));
+		_mm_storeu_ps(ry, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m10), _mm_mul_ps(y, m11)), _mm_mul_ps(z, m12)));
+		_mm_storeu_ps(rz, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m20), _mm_mul_ps(y, m21)), _mm_mul_ps(z, m22)));
+		for (int j = 0; j < 4; ++j) out[i + j].set(rx[j], ry[j], rz[j]);
+	}
+
+	for (; i < count; ++i) out[i] = Vector3f(in[i]).rot(*this);
+}
+
+#else
+
+inline Matrix4& Matrix4::operator*=(const Matrix4 &other)
+{
+	float tmpVal[16];
+	memcpy(tmpVal, val, 16*sizeof(float));
+
+	for (int c = 0; c < 4; ++c)
+	{
+		for (int r = 0; r < 4; ++r)
+		{
+			val[c*4 + r] = tmpVal[r]*other.val[c*4] + tmpVal[4 + r]*other.val[c*4 + 1]
+			             + tmpVal[8 + r]*other.val[c*4 + 2] + tmpVal[12 + r]*other.val[c*4 + 3];
+		}
+	}
+
+	return *this;
+}
+
+inline void Matrix4::transformPoints(const Vector3f *in, Vector3f *out, const size_t &count) const
+{
+	for (size_t i = 0; i < count; ++i) out[i] = Vector3f(in[i]).mul(*this);
+}
+
+inline void Matrix4::rotateVectors(const Vector3f *in, Vector3f *out, const size_t &count) const
+{
+	for (size_t i = 0; i < count; ++i) out[i] = Vector3f(in[i]).rot(*this);
+}
+
+#endif /* MATRIX4_SSE */
+
+#endif /* MATRIX_4_H */
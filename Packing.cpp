@@ -0,0 +1,91 @@
+#include "Packing.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+using namespace std;
+
+sf::Uint16 packHalf(const float &f)
+{
+	sf::Uint32 bits;
+	memcpy(&bits, &f, sizeof(bits));
+
+	sf::Uint16 sign = (sf::Uint16)((bits >> 16) & 0x8000);
+	int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+	sf::Uint32 mantissa = bits & 0x7fffff;
+
+	// NaN stays NaN, infinity and overflow become infinity
+	if (((bits >> 23) & 0xff) == 0xff) return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+	if (exponent >= 31) return sign | 0x7c00;
+	if (exponent <= 0) return sign;
+
+	// Round to nearest even on the 13 dropped bits, a carry into the
+	// exponent is still the right encoding
+	sf::Uint32 half = ((sf::Uint32)exponent << 10) | (mantissa >> 13);
+	sf::Uint32 rest = mantissa & 0x1fff;
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) ++half;
+
+	return sign | (sf::Uint16)min(half, (sf::Uint32)0x7c00);
+}
+
+float unpackHalf(const sf::Uint16 &h)
+{
+	sf::Uint32 sign = (sf::Uint32)(h & 0x8000) << 16;
+	sf::Uint32 exponent = (h >> 10) & 0x1f;
+	sf::Uint32 mantissa = h & 0x3ff;
+
+	sf::Uint32 bits;
+	if (exponent == 0) bits = sign;
+	else if (exponent == 31) bits = sign | 0x7f800000 | (mantissa << 13);
+	else bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+static float signNotZero(const float &v)
+{
+	return v < 0.0f ? -1.0f : 1.0f;
+}
+
+static sf::Int16 snorm16(const float &v)
+{
+	return (sf::Int16)floor(max(-1.0f, min(1.0f, v)) * 32767.0f + 0.5f);
+}
+
+void packNormal(const Vector3f &n, sf::Int16 out[2])
+{
+	float l1 = abs(n.x) + abs(n.y) + abs(n.z);
+	float x = n.x / l1;
+	float y = n.y / l1;
+
+	// The lower half folds over the diagonals
+	if (n.z < 0.0f)
+	{
+		float fx = (1.0f - abs(y)) * signNotZero(x);
+		float fy = (1.0f - abs(x)) * signNotZero(y);
+		x = fx;
+		y = fy;
+	}
+
+	out[0] = snorm16(x);
+	out[1] = snorm16(y);
+}
+
+Vector3f unpackNormal(const sf::Int16 in[2])
+{
+	float x = in[0] / 32767.0f;
+	float y = in[1] / 32767.0f;
+	float z = 1.0f - abs(x) - abs(y);
+
+	if (z < 0.0f)
+	{
+		float fx = (1.0f - abs(y)) * signNotZero(x);
+		float fy = (1.0f - abs(x)) * signNotZero(y);
+		x = fx;
+		y = fy;
+	}
+
+	return Vector3f(x, y, z).normalize();
+}
@@ -0,0 +1,18 @@
+#ifndef PACKING_H
+#define PACKING_H
+
+#include <SFML/Config.hpp>
+
+#include "Vector3f.h"
+
+// IEEE half precision, rounded to nearest even. Values below the smallest
+// normal half flush to zero, values above the largest become infinity.
+sf::Uint16 packHalf(const float &f);
+float unpackHalf(const sf::Uint16 &h);
+
+// A unit vector folded onto an octahedron and stored as two snorm16
+// coordinates, about 1e-4 radians of error in 4 bytes instead of 12
+void packNormal(const Vector3f &n, sf::Int16 out[2]);
+Vector3f unpackNormal(const sf::Int16 in[2]);
+
+#endif /* PACKING_H */
@@ -0,0 +1,205 @@
+#include "ParameterSweep.h"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+using namespace std;
+
+#include "RenderBenchmark.h"
+#include "BenchmarkStats.h"
+#include "ImageMetrics.h"
+#include "Constants.h"
+
+template <typename T, size_t N>
+static size_t lengthOf(const T (&)[N]) { return N; }
+
+ParameterSweep::ParameterSweep()
+	: size(SWEEP_WIDTH, SWEEP_HEIGHT)
+	, settings()
+	, presets()
+{}
+
+int ParameterSweep::run(const string &jsonFile)
+{
+	const int threads = max(1, (int)thread::hardware_concurrency());
+	const vector<pair<string, ViewState>> poses = RenderBenchmark::referencePoses();
+
+	CpuMarcher::Quality reference;
+	reference.maxSteps = SWEEP_REFERENCE_MAX_STEPS;
+	reference.epsilonFactor = SWEEP_REFERENCE_EPSILON_FACTOR;
+	reference.maxIter = SWEEP_REFERENCE_MAX_ITER;
+	reference.stepFactor = SWEEP_REFERENCE_STEP_FACTOR;
+	reference.stepTint = false;
+
+	cout << "Rendering references at " << size.x << "x" << size.y << endl;
+	vector<vector<sf::Uint8>> references(poses.size());
+	vector<CpuMarcher::RayCost> costs(size.x * size.y);
+	for (size_t p = 0; p < poses.size(); ++p)
+	{
+		references[p].resize(size.x * size.y * 4);
+		RenderBenchmark::renderFrame(poses[p].second, size, reference, threads, references[p], costs);
+	}
+
+	for (size_t a = 0; a < lengthOf(SWEEP_MAX_STEPS); ++a)
+	for (size_t b = 0; b < lengthOf(SWEEP_EPSILON_FACTORS); ++b)
+	for (size_t c = 0; c < lengthOf(SWEEP_MAX_ITER); ++c)
+	for (size_t d = 0; d < lengthOf(SWEEP_STEP_FACTORS); ++d)
+	for (size_t e = 0; e < lengthOf(SWEEP_RESOLUTIONS); ++e)
+	{
+		Setting s = Setting();
+		s.quality.maxSteps = SWEEP_MAX_STEPS[a];
+		s.quality.epsilonFactor = SWEEP_EPSILON_FACTORS[b];
+		s.quality.maxIter = SWEEP_MAX_ITER[c];
+		s.quality.stepFactor = SWEEP_STEP_FACTORS[d];
+		s.quality.stepTint = false;
+		s.resolution = SWEEP_RESOLUTIONS[e];
+
+		sf::Vector2u scaled(max(1u, (unsigned int)(size.x * s.resolution + 0.5f)),
+		                    max(1u, (unsigned int)(size.y * s.resolution + 0.5f)));
+		vector<sf::Uint8> pixels(scaled.x * scaled.y * 4);
+		costs.resize(scaled.x * scaled.y);
+
+		for (size_t p = 0; p < poses.size(); ++p)
+		{
+			vector<double> walls;
+			for (int i = 0; i < SWEEP_REPEATS; ++i)
+			{
+				walls.push_back(RenderBenchmark::renderFrame(poses[p].second, scaled, s.quality, threads, pixels, costs));
+			}
+			s.ms += percentile(walls, 0.5);
+
+			double evals = 0.0;
+			for (const auto &cost : costs) evals += cost.evals;
+			s.evalsPerPixel += evals / costs.size() / poses.size();
+
+			vector<sf::Uint8> image = resizeBilinear(pixels, scaled, size);
+			s.psnr += psnr(image, references[p]) / poses.size();
+			s.ssim += ssim(image, references[p], size) / poses.size();
+		}
+
+		settings.push_back(s);
+	}
+
+	markFrontier();
+
+	cout << "Pareto frontier of " << settings.size() << " settings over " << poses.size() << " poses" << endl;
+	cout << right << setw(8) << "steps" << setw(10) << "epsilon" << setw(6) << "iter" << setw(8) << "step"
+		 << setw(8) << "scale" << setw(10) << "ms" << setw(10) << "evals/px" << setw(8) << "PSNR" << setw(8) << "SSIM" << endl;
+	vector<const Setting*> frontier;
+	for (const auto &s : settings)
+	{
+		if (s.pareto) frontier.push_back(&s);
+	}
+	sort(frontier.begin(), frontier.end(), [](const Setting *a, const Setting *b) { return a->ms < b->ms; });
+	for (auto s : frontier) printSetting(*s);
+
+	presets.push_back({ "interactive", SWEEP_INTERACTIVE_SSIM, cheapestOver(SWEEP_INTERACTIVE_SSIM) });
+	presets.push_back({ "preview", SWEEP_PREVIEW_SSIM, cheapestOver(SWEEP_PREVIEW_SSIM) });
+	presets.push_back({ "final", SWEEP_FINAL_SSIM, cheapestOver(SWEEP_FINAL_SSIM) });
+
+	cout << "Presets" << endl;
+	for (const auto &p : presets)
+	{
+		cout << left << setw(12) << p.name << right << "SSIM >= " << fixed << setprecision(2) << p.minSsim;
+		if (settings[p.setting].ssim < p.minSsim) cout << ", not reached, best found";
+		cout << endl;
+		printSetting(settings[p.setting]);
+	}
+
+	if (!writeJson(jsonFile))
+	{
+		cout << "Unable to write " << jsonFile << endl;
+		return EXIT_FAILURE;
+	}
+
+	cout << "Results written to " << jsonFile << endl;
+	return EXIT_SUCCESS;
+}
+
+// A setting is on the frontier when every cheaper one has a lower SSIM
+void ParameterSweep::markFrontier()
+{
+	vector<int> order(settings.size());
+	for (size_t i = 0; i < order.size(); ++i) order[i] = (int)i;
+	sort(order.begin(), order.end(), [this](const int &a, const int &b) {
+		if (settings[a].ms != settings[b].ms) return settings[a].ms < settings[b].ms;
+		return settings[a].ssim > settings[b].ssim;
+	});
+
+	double best = -1.0;
+	for (int i : order)
+	{
+		settings[i].pareto = settings[i].ssim > best;
+		best = max(best, settings[i].ssim);
+	}
+}
+
+// The cheapest setting that reaches minSsim, or the best one when none does
+int ParameterSweep::cheapestOver(const float &minSsim) const
+{
+	int cheapest = -1;
+	int best = 0;
+	for (size_t i = 0; i < settings.size(); ++i)
+	{
+		if (settings[i].ssim > settings[best].ssim) best = (int)i;
+		if (settings[i].ssim >= minSsim && (cheapest < 0 || settings[i].ms < settings[cheapest].ms)) cheapest = (int)i;
+	}
+	return cheapest >= 0 ? cheapest : best;
+}
+
+void ParameterSweep::printSetting(const Setting &s) const
+{
+	cout << right << setw(8) << s.quality.maxSteps << setw(10) << defaultfloat << setprecision(3) << s.quality.epsilonFactor
+		 << setw(6) << s.quality.maxIter << fixed << setprecision(2) << setw(8) << s.quality.stepFactor
+		 << setw(8) << s.resolution << setprecision(1) << setw(10) << s.ms << setprecision(2) << setw(10) << s.evalsPerPixel
+		 << setw(8) << s.psnr << setprecision(3) << setw(8) << s.ssim << endl;
+}
+
+bool ParameterSweep::writeJson(const string &filename) const
+{
+	ofstream out(filename.c_str());
+	if (!out) return false;
+
+	out << "{\n"
+		<< "  \"benchmark\": \"sweep\",\n"
+		<< "  \"width\": " << size.x << ",\n"
+		<< "  \"height\": " << size.y << ",\n"
+		<< "  \"repeats\": " << SWEEP_REPEATS << ",\n"
+		<< "  \"reference\": { \"max_steps\": " << SWEEP_REFERENCE_MAX_STEPS
+		<< ", \"epsilon_factor\": " << SWEEP_REFERENCE_EPSILON_FACTOR
+		<< ", \"max_iter\": " << SWEEP_REFERENCE_MAX_ITER
+		<< ", \"step_factor\": " << SWEEP_REFERENCE_STEP_FACTOR << " },\n"
+		<< "  \"presets\": {\n";
+
+	out << setprecision(6);
+	for (size_t i = 0; i < presets.size(); ++i)
+	{
+		out << "    \"" << presets[i].name << "\": { \"min_ssim\": " << presets[i].minSsim
+			<< ", \"setting\": " << presets[i].setting << " }" << (i + 1 < presets.size() ? "," : "") << "\n";
+	}
+
+	out << "  },\n"
+		<< "  \"settings\": [\n";
+
+	for (size_t i = 0; i < settings.size(); ++i)
+	{
+		const Setting &s = settings[i];
+		out << "    { \"max_steps\": " << s.quality.maxSteps
+			<< ", \"epsilon_factor\": " << s.quality.epsilonFactor
+			<< ", \"max_iter\": " << s.quality.maxIter
+			<< ", \"step_factor\": " << s.quality.stepFactor
+			<< ", \"resolution\": " << s.resolution
+			<< ", \"ms\": " << s.ms
+			<< ", \"evals_per_pixel\": " << s.evalsPerPixel
+			<< ", \"psnr\": " << s.psnr
+			<< ", \"ssim\": " << s.ssim
+			<< ", \"pareto\": " << (s.pareto ? "true" : "false") << " }"
+			<< (i + 1 < settings.size() ? "," : "") << "\n";
+	}
+
+	out << "  ]\n}\n";
+	return (bool)out;
+}
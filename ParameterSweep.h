@@ -0,0 +1,61 @@
+#ifndef PARAMETER_SWEEP_H
+#define PARAMETER_SWEEP_H
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <SFML/System/Vector2.hpp>
+
+#include "CpuMarcher.h"
+
+/*
+ * Quality against cost of the march settings. Every combination of the
+ * SWEEP_* step budgets, epsilon factors, orbit iterations, step factors and
+ * resolutions renders the reference poses on the CPU, is timed, and is
+ * scored with PSNR and SSIM against a render with the SWEEP_REFERENCE_*
+ * settings. The settings no other setting beats on both time and SSIM form
+ * the Pareto frontier, and the cheapest frontier setting over each
+ * SWEEP_*_SSIM threshold is recommended as the interactive, preview and
+ * final preset. The step count tint grows with the budget itself, so it is
+ * left out of every image that is scored.
+ */
+class ParameterSweep
+{
+public:
+	ParameterSweep();
+
+	// Prints the frontier and presets and writes every setting as JSON,
+	// returns the exit code
+	int run(const string &jsonFile);
+
+private:
+	struct Setting
+	{
+		CpuMarcher::Quality quality;
+		float resolution;
+		double ms;            // Summed over the poses
+		double evalsPerPixel; // Mean over the poses, at the setting's resolution
+		double psnr;          // Means over the poses
+		double ssim;
+		bool pareto;
+	};
+
+	struct Preset
+	{
+		string name;
+		float minSsim;
+		int setting;
+	};
+
+	sf::Vector2u size;
+	vector<Setting> settings;
+	vector<Preset> presets;
+
+	void markFrontier();
+	int cheapestOver(const float &minSsim) const;
+	void printSetting(const Setting &s) const;
+	bool writeJson(const string &filename) const;
+};
+
+#endif /* PARAMETER_SWEEP_H */
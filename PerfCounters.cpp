@@ -0,0 +1,188 @@
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+static int openEvent(const uint32_t &type, const uint64_t &config)
+{
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = 1;
+	attr.inherit = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// The raw FP_ARITH_INST_RETIRED encodings mean something else, or nothing,
+// on other vendors and on Intel cores before Broadwell
+static bool hasFpArithEvents()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx)) return false;
+	char vendor[13];
+	memcpy(vendor, &ebx, 4);
+	memcpy(vendor + 4, &edx, 4);
+	memcpy(vendor + 8, &ecx, 4);
+	vendor[12] = '\0';
+	if (strcmp(vendor, "GenuineIntel") != 0) return false;
+
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+	unsigned int family = (eax >> 8) & 0xf;
+	unsigned int model = ((eax >> 4) & 0xf) | ((eax >> 12) & 0xf0);
+	if (family != 6) return false;
+
+	// Broadwell, Skylake and their successors, big cores only
+	const unsigned int models[] = {
+		0x3d, 0x47, 0x4f, 0x56,                   // Broadwell
+		0x4e, 0x5e, 0x55, 0x8e, 0x9e, 0xa5, 0xa6, // Skylake, Kaby, Coffee, Comet Lake
+		0x66, 0x6a, 0x6c, 0x7d, 0x7e,             // Cannon, Ice Lake
+		0x8c, 0x8d, 0xa7, 0x8f, 0xcf,             // Tiger, Rocket, Sapphire, Emerald Rapids
+		0x97, 0x9a, 0xb7, 0xba, 0xbf,             // Alder, Raptor Lake
+		0xaa, 0xac, 0xad, 0xae, 0xc5, 0xc6, 0xbd  // Meteor, Granite Rapids, Arrow, Lunar Lake
+	};
+	for (unsigned int m : models)
+	{
+		if (m == model) return true;
+	}
+	return false;
+#else
+	return false;
+#endif
+}
+#endif
+
+PerfCounters::PerfCounters()
+	: cycles({ -1, 1.0 })
+	, instructions({ -1, 1.0 })
+	, cacheMisses({ -1, 1.0 })
+	, branchMisses({ -1, 1.0 })
+	, flops()
+	, opened(false)
+{}
+
+PerfCounters::~PerfCounters()
+{
+	close(cycles);
+	close(instructions);
+	close(cacheMisses);
+	close(branchMisses);
+	for (auto &c : flops) close(c);
+}
+
+bool PerfCounters::open()
+{
+#ifdef __linux__
+	cycles.fd = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+	instructions.fd = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+	cacheMisses.fd = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+	branchMisses.fd = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+	opened = cycles.fd >= 0 && instructions.fd >= 0;
+
+	// FP_ARITH_INST_RETIRED: scalar, 128 bit and 256 bit packed single
+	const uint64_t fpEvents[3] = { 0x02c7, 0x08c7, 0x20c7 };
+	const double fpWidths[3] = { 1.0, 4.0, 8.0 };
+	bool fpArith = opened && hasFpArithEvents();
+	for (int i = 0; fpArith && i < 3; ++i)
+	{
+		Counter c = { openEvent(PERF_TYPE_RAW, fpEvents[i]), fpWidths[i] };
+		if (c.fd < 0) break;
+		flops.push_back(c);
+	}
+	if (flops.size() < 3)
+	{
+		for (auto &c : flops) close(c);
+		flops.clear();
+	}
+#endif
+	return opened;
+}
+
+bool PerfCounters::isOpen() const
+{
+	return opened;
+}
+
+bool PerfCounters::hasFlops() const
+{
+	return !flops.empty();
+}
+
+void PerfCounters::start()
+{
+#ifdef __linux__
+	if (!opened) return;
+
+	const Counter *all[4] = { &cycles, &instructions, &cacheMisses, &branchMisses };
+	for (auto c : all)
+	{
+		if (c->fd < 0) continue;
+		ioctl(c->fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(c->fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+	for (auto &c : flops)
+	{
+		ioctl(c.fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(c.fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+#endif
+}
+
+PerfCounters::Reading PerfCounters::stop()
+{
+	Reading r = { 0.0, 0.0, 0.0, 0.0, 0.0, false };
+
+#ifdef __linux__
+	if (!opened) return r;
+
+	const Counter *all[4] = { &cycles, &instructions, &cacheMisses, &branchMisses };
+	for (auto c : all)
+	{
+		if (c->fd >= 0) ioctl(c->fd, PERF_EVENT_IOC_DISABLE, 0);
+	}
+	for (auto &c : flops) ioctl(c.fd, PERF_EVENT_IOC_DISABLE, 0);
+
+	r.cycles = read(cycles);
+	r.instructions = read(instructions);
+	r.cacheMisses = read(cacheMisses);
+	r.branchMisses = read(branchMisses);
+	for (auto &c : flops) r.flops += read(c) * c.weight;
+	r.hasFlops = !flops.empty();
+#endif
+	return r;
+}
+
+// Scaled up when the kernel multiplexed the counter with others
+double PerfCounters::read(const Counter &c)
+{
+#ifdef __linux__
+	uint64_t values[3] = { 0, 0, 0 };
+	if (c.fd < 0 || ::read(c.fd, values, sizeof(values)) != sizeof(values)) return 0.0;
+	if (values[2] == 0) return 0.0;
+	return (double)values[0] * values[1] / values[2];
+#else
+	return 0.0;
+#endif
+}
+
+void PerfCounters::close(Counter &c)
+{
+#ifdef __linux__
+	if (c.fd >= 0) ::close(c.fd);
+#endif
+	c.fd = -1;
+}
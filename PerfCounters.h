@@ -0,0 +1,57 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <vector>
+using namespace std;
+
+/*
+ * Hardware counters around a measured region through perf_event_open, for
+ * the benchmarks. Counts the calling thread and the threads it starts, as
+ * long as they have exited by stop(). Floating point operations are read
+ * from Intel's FP_ARITH_INST_RETIRED single precision events and weighted by
+ * vector width, on the Intel cores CPUID says have them; elsewhere they are
+ * missing from the reading. Off Linux, or when the kernel refuses, open()
+ * fails and the benchmarks report timings only.
+ */
+class PerfCounters
+{
+public:
+	struct Reading
+	{
+		double cycles;
+		double instructions;
+		double cacheMisses;
+		double branchMisses;
+		double flops;
+		bool hasFlops;
+	};
+
+	PerfCounters();
+	~PerfCounters();
+
+	bool open();
+	bool isOpen() const;
+	bool hasFlops() const;
+
+	void start();
+	Reading stop();
+
+private:
+	struct Counter
+	{
+		int fd;
+		double weight;  // Operations per count, for the vector FP events
+	};
+
+	Counter cycles;
+	Counter instructions;
+	Counter cacheMisses;
+	Counter branchMisses;
+	vector<Counter> flops;
+	bool opened;
+
+	static double read(const Counter &c);
+	void close(Counter &c);
+};
+
+#endif /* PERF_COUNTERS_H */
@@ -0,0 +1,73 @@
+#include "PixelOrder.h"
+
+void PixelOrder::build(const Curve &curve, const int &w, const int &h, vector<int> &cells)
+{
+	cells.clear();
+
+	if (curve == RowMajor)
+	{
+		for (int i = 0; i < w * h; ++i) cells.push_back(i);
+		return;
+	}
+
+	int n = 1;
+	while (n < w || n < h) n *= 2;
+
+	for (unsigned int d = 0; d < (unsigned int)(n * n); ++d)
+	{
+		int x, y;
+		if (curve == Morton) mortonCell(d, x, y);
+		else hilbertCell(n, d, x, y);
+
+		if (x < w && y < h) cells.push_back(y * w + x);
+	}
+}
+
+const char* PixelOrder::name(const Curve &curve)
+{
+	switch (curve)
+	{
+	case Morton: return "morton";
+	case Hilbert: return "hilbert";
+	default: return "row_major";
+	}
+}
+
+// Even bits of d are x, odd bits y, so runs of 8 cells are 4x2 blocks
+void PixelOrder::mortonCell(unsigned int d, int &x, int &y)
+{
+	x = 0;
+	y = 0;
+	for (int bit = 0; d != 0; ++bit, d >>= 2)
+	{
+		x |= (d & 1) << bit;
+		y |= ((d >> 1) & 1) << bit;
+	}
+}
+
+// The d2xy of the usual quadrant rotating construction, n a power of two
+void PixelOrder::hilbertCell(const int &n, unsigned int d, int &x, int &y)
+{
+	x = 0;
+	y = 0;
+	for (int s = 1; s < n; s *= 2, d /= 4)
+	{
+		int rx = 1 & (d / 2);
+		int ry = 1 & (d ^ rx);
+
+		if (ry == 0)
+		{
+			if (rx == 1)
+			{
+				x = s - 1 - x;
+				y = s - 1 - y;
+			}
+			int t = x;
+			x = y;
+			y = t;
+		}
+
+		x += s * rx;
+		y += s * ry;
+	}
+}
@@ -0,0 +1,35 @@
+#ifndef PIXEL_ORDER_H
+#define PIXEL_ORDER_H
+
+#include <vector>
+using namespace std;
+
+/*
+ * Visiting orders for the cells of a grid, the tiles of a frame or the
+ * pixels of a tile. Along a Morton or Hilbert curve cells that are visited
+ * one after another are also close on screen, so consecutive rays march
+ * nearly the same path and share a packet well. Grids that are not a power
+ * of two square walk the curve of the enclosing one and skip the cells
+ * outside.
+ */
+class PixelOrder
+{
+public:
+	enum Curve
+	{
+		RowMajor,
+		Morton,
+		Hilbert
+	};
+
+	// Cell indices, y * w + x, in the order the curve visits them
+	static void build(const Curve &curve, const int &w, const int &h, vector<int> &cells);
+
+	static const char* name(const Curve &curve);
+
+private:
+	static void mortonCell(unsigned int d, int &x, int &y);
+	static void hilbertCell(const int &n, unsigned int d, int &x, int &y);
+};
+
+#endif /* PIXEL_ORDER_H */
@@ -1,74 +1,13 @@
+// Enable constants like PI, before the header pulls in cmath
+#define _USE_MATH_DEFINES
 #include "Quaternion.h"
 
-#define _USE_MATH_DEFINES
 #include <cmath>
 
 #include "Vector3f.h"
 
 const float M_PI2 = 2.0f * (float)M_PI;
 
-Quaternion::Quaternion()
-	: x(0), y(0), z(0), w(1)
-{}
-
-Quaternion::Quaternion(float x, float y, float z, float w)
-	: x(x), y(y), z(z), w(w)
-{}
-
-Quaternion::Quaternion(const Quaternion& other)
-	: x(other.x)
-	, y(other.y)
-	, z(other.z)
-	, w(other.w)
-{
-}
-
-Quaternion::Quaternion(Quaternion&& other)
-	: x(other.x)
-	, y(other.y)
-	, z(other.z)
-	, w(other.w)
-{}
-
-
-Quaternion& Quaternion::set(const float &x, const float &y, const float &z, const float &w)
-{
-	this->x = x;
-	this->y = y;
-	this->z = z;
-	this->w = w;
-	return *this;
-}
-
-Quaternion& Quaternion::set(const Vector3f &axis, const float &degrees)
-{
-	return setFromAxis(axis.x, axis.y, axis.z, degrees);
-}
-
-Quaternion& Quaternion::idt()
-{
-	return set(0.0f, 0.0f, 0.0f, 1.0f);
-}
-
-float Quaternion::len2()
-{
-	return x * x + y * y + z * z + w * w;
-}
-
-Quaternion& Quaternion::nor()
-{
-	float len = len2();
-	if (len != 0.0f) {
-		len = sqrt(len);
-		w /= len;
-		x /= len;
-		y /= len;
-		z /= len;
-	}
-
-	return *this;
-}
-
 Quaternion& Quaternion::setFromAxis(const float axisX, const float axisY, const float axisZ, const float degrees)
 {
 	return setFromAxisRad(axisX, axisY, axisZ, degrees * (float)M_PI / 180.0f);
@@ -87,3 +26,59 @@ Quaternion& Quaternion::setFromAxisRad(const float x, const float y, const float
 	
 	return set(d * x * l_sin, d * y * l_sin, d * z * l_sin, l_cos).nor();
 }
+
+Quaternion& Quaternion::setFromAxes(const Vector3f &xAxis, const Vector3f &yAxis, const Vector3f &zAxis)
+{
+	// Rotation matrix with the axes as columns
+	const float m00 = xAxis.x, m01 = yAxis.x, m02 = zAxis.x;
+	const float m10 = xAxis.y, m11 = yAxis.y, m12 = zAxis.y;
+	const float m20 = xAxis.z, m21 = yAxis.z, m22 = zAxis.z;
+
+	const float t = m00 + m11 + m22;
+	if (t > 0.0f)
+	{
+		float s = 0.5f / sqrt(t + 1.0f);
+		return set((m21 - m12) * s, (m02 - m20) * s, (m10 - m01) * s, 0.25f / s).nor();
+	}
+	else if (m00 > m11 && m00 > m22)
+	{
+		float s = 2.0f * sqrt(1.0f + m00 - m11 - m22);
+		return set(0.25f * s, (m01 + m10) / s, (m02 + m20) / s, (m21 - m12) / s).nor();
+	}
+	else if (m11 > m22)
+	{
+		float s = 2.0f * sqrt(1.0f + m11 - m00 - m22);
+		return set((m01 + m10) / s, 0.25f * s, (m12 + m21) / s, (m02 - m20) / s).nor();
+	}
+	else
+	{
+		float s = 2.0f * sqrt(1.0f + m22 - m00 - m11);
+		return set((m02 + m20) / s, (m12 + m21) / s, 0.25f * s, (m10 - m01) / s).nor();
+	}
+}
+
+Quaternion& Quaternion::slerp(const Quaternion &end, const float &alpha)
+{
+	// Take the short way around
+	float d = dot(end);
+	float sign = d < 0.0f ? -1.0f : 1.0f;
+	d *= sign;
+
+	float scale0 = 1.0f - alpha;
+	float scale1 = alpha;
+
+	// Nearly parallel quaternions fall back to a normalized lerp
+	if (1.0f - d > 0.001f)
+	{
+		float theta = acos(d);
+		float invSinTheta = 1.0f / sin(theta);
+		scale0 = sin((1.0f - alpha) * theta) * invSinTheta;
+		scale1 = sin(alpha * theta) * invSinTheta;
+	}
+
+	scale1 *= sign;
+	return set( scale0 * x + scale1 * end.x
+	          , scale0 * y + scale1 * end.y
+	          , scale0 * z + scale1 * end.z
+	          , scale0 * w + scale1 * end.w).nor();
+}
@@ -1,18 +1,22 @@
 #ifndef QUATERNION_H
 #define QUATERNION_H
 
-class Vector3f;
+#include <cmath>
 
+#include "Vector3f.h"
+
+// The small operations are inline below, the trigonometry stays in the .cpp
 class Quaternion
 {
 public:
 	float x, y, z, w;
 
-	Quaternion();
-	Quaternion(float x, float y, float z, float w);
+	constexpr Quaternion();
+	constexpr Quaternion(float x, float y, float z, float w);
 
-	Quaternion(const Quaternion& other);
-	Quaternion(Quaternion&& other);
+	Quaternion(const Quaternion& other) = default;
+	Quaternion(Quaternion&& other) = default;
+	Quaternion& operator=(const Quaternion& other) = default;
 
 	Quaternion& set(const float &x, const float &y, const float &z, const float &w);
 	Quaternion& set(const Vector3f &axis, const float &degrees);
@@ -23,6 +27,73 @@ public:
 
 	Quaternion& setFromAxis(const float axisX, const float axisY, const float axisZ, const float degrees);
 	Quaternion& setFromAxisRad(const float axisX, const float axisY, const float axisZ, const float radians);
+
+	// Sets the rotation that maps the unit axes onto the given orthonormal axes
+	Quaternion& setFromAxes(const Vector3f &xAxis, const Vector3f &yAxis, const Vector3f &zAxis);
+
+	constexpr float dot(const Quaternion &other) const;
+	Quaternion& slerp(const Quaternion &end, const float &alpha);
+
+	Vector3f& transform(Vector3f &v) const;
 };
 
+constexpr Quaternion::Quaternion()
+	: x(0), y(0), z(0), w(1)
+{}
+
+constexpr Quaternion::Quaternion(float x, float y, float z, float w)
+	: x(x), y(y), z(z), w(w)
+{}
+
+inline Quaternion& Quaternion::set(const float &x, const float &y, const float &z, const float &w)
+{
+	this->x = x;
+	this->y = y;
+	this->z = z;
+	this->w = w;
+	return *this;
+}
+
+inline Quaternion& Quaternion::set(const Vector3f &axis, const float &degrees)
+{
+	return setFromAxis(axis.x, axis.y, axis.z, degrees);
+}
+
+inline Quaternion& Quaternion::idt()
+{
+	return set(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+inline float Quaternion::len2()
+{
+	return x * x + y * y + z * z + w * w;
+}
+
+inline Quaternion& Quaternion::nor()
+{
+	float len = len2();
+	if (len != 0.0f) {
+		len = std::sqrt(len);
+		w /= len;
+		x /= len;
+		y /= len;
+		z /= len;
+	}
+
+	return *this;
+}
+
+constexpr float Quaternion::dot(const Quaternion &other) const
+{
+	return x * other.x + y * other.y + z * other.z + w * other.w;
+}
+
+inline Vector3f& Quaternion::transform(Vector3f &v) const
+{
+	// v' = v + 2w(q x v) + 2q x (q x v)
+	Vector3f q(x, y, z);
+	Vector3f t = Vector3f::cross(q, v) * 2.0f;
+	return v += t * w + Vector3f::cross(q, t);
+}
+
 #endif /* QUATERNION_H */
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "RayProbe.h"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <cstdlib>
+using namespace std;
+
+#include "RenderBenchmark.h"
+#include "Constants.h"
+
+RayProbe::RayProbe()
+	: pixels()
+	, traces()
+{}
+
+void RayProbe::addPixel(const int &x, const int &y)
+{
+	pixels.push_back(sf::Vector2i(x, y));
+}
+
+void RayProbe::trace(const ViewState &view, const sf::Vector2u &size, const CpuMarcher::Quality &quality)
+{
+	CpuMarcher marcher;
+	marcher.setView(view, size);
+	marcher.setQuality(quality);
+
+	traces.clear();
+	for (const auto &p : pixels)
+	{
+		if (p.x < 0 || p.y < 0 || p.x >= (int)size.x || p.y >= (int)size.y) continue;
+
+		traces.push_back(CpuMarcher::RayTrace());
+		marcher.tracePixel(p.x, p.y, traces.back());
+	}
+}
+
+const vector<CpuMarcher::RayTrace>& RayProbe::getTraces() const
+{
+	return traces;
+}
+
+int RayProbe::run(const string &pose, const vector<string> &pixels)
+{
+	const sf::Vector2u size(BENCH_RENDER_WIDTH, BENCH_RENDER_HEIGHT);
+
+	const ViewState *view = nullptr;
+	const vector<pair<string, ViewState>> poses = RenderBenchmark::referencePoses();
+	for (const auto &p : poses)
+	{
+		if (p.first == pose) view = &p.second;
+	}
+
+	if (view == nullptr)
+	{
+		cout << "Unknown pose " << pose << ", one of";
+		for (const auto &p : poses) cout << " " << p.first;
+		cout << endl;
+		return EXIT_FAILURE;
+	}
+
+	RayProbe probe;
+	for (const auto &s : pixels)
+	{
+		int x, y;
+		char comma;
+		istringstream in(s);
+		if (!(in >> x >> comma >> y) || comma != ',' || x < 0 || y < 0 || x >= (int)size.x || y >= (int)size.y)
+		{
+			cout << "Pixel " << s << " is not x,y inside " << size.x << "x" << size.y << endl;
+			return EXIT_FAILURE;
+		}
+		probe.addPixel(x, y);
+	}
+
+	// Traces are single rays, so is the image they are checked against
+	CpuMarcher::Quality quality;
+	quality.mode = CpuMarcher::ScalarMarch;
+
+	vector<sf::Uint8> image(size.x * size.y * 4);
+	vector<CpuMarcher::RayCost> costs(size.x * size.y);
+	RenderBenchmark::renderFrame(*view, size, quality, max(1, (int)thread::hardware_concurrency()), image, costs);
+	probe.trace(*view, size, quality);
+
+	string imageFile = "probe_" + pose + ".ppm";
+	string jsonFile = "probe_" + pose + ".json";
+	if (!writePpm(imageFile, size, image) || !probe.writeJson(jsonFile, imageFile, size))
+	{
+		cout << "Unable to write " << imageFile << " and " << jsonFile << endl;
+		return EXIT_FAILURE;
+	}
+
+	for (const auto &t : probe.getTraces())
+	{
+		int iterations = 0;
+		for (const auto &s : t.steps) iterations += s.iterations;
+		for (const auto &s : t.normalTaps) iterations += s.iterations;
+
+		cout << t.x << "," << t.y << ": " << terminationName(t.termination) << " after " << t.steps.size()
+			 << " steps, " << iterations << " iterations, t " << t.t << endl;
+	}
+
+	cout << "Traces written to " << jsonFile << ", image to " << imageFile << endl;
+	return EXIT_SUCCESS;
+}
+
+const char* RayProbe::terminationName(const CpuMarcher::Termination &termination)
+{
+	switch (termination)
+	{
+	case CpuMarcher::Hit: return "hit";
+	case CpuMarcher::MaxSteps: return "max_steps";
+	default: return "left_view";
+	}
+}
+
+bool RayProbe::writeJson(const string &filename, const string &imageFile, const sf::Vector2u &size) const
+{
+	ofstream out(filename.c_str());
+	if (!out) return false;
+
+	out << "{\n"
+		<< "  \"image\": \"" << imageFile << "\",\n"
+		<< "  \"width\": " << size.x << ",\n"
+		<< "  \"height\": " << size.y << ",\n"
+		<< "  \"rays\": [\n";
+
+	out << setprecision(9);
+	for (size_t i = 0; i < traces.size(); ++i)
+	{
+		const CpuMarcher::RayTrace &r = traces[i];
+		out << "    {\n"
+			<< "      \"x\": " << r.x << ", \"y\": " << r.y << ",\n"
+			<< "      \"termination\": \"" << terminationName(r.termination) << "\",\n"
+			<< "      \"t\": " << r.t << ",\n"
+			<< "      \"rgba\": [" << (int)r.rgba[0] << ", " << (int)r.rgba[1] << ", " << (int)r.rgba[2] << ", " << (int)r.rgba[3] << "],\n"
+			<< "      \"normal\": [" << r.normal.x << ", " << r.normal.y << ", " << r.normal.z << "],\n"
+			<< "      \"steps\": [\n";
+
+		for (size_t j = 0; j < r.steps.size(); ++j)
+		{
+			const CpuMarcher::RayTrace::Step &s = r.steps[j];
+			out << "        { \"t\": " << s.t << ", \"h\": " << s.h << ", \"eps\": " << s.eps
+				<< ", \"iterations\": " << s.iterations << " }" << (j + 1 < r.steps.size() ? "," : "") << "\n";
+		}
+
+		out << "      ],\n"
+			<< "      \"normal_taps\": [\n";
+
+		for (size_t j = 0; j < r.normalTaps.size(); ++j)
+		{
+			const CpuMarcher::RayTrace::Tap &s = r.normalTaps[j];
+			out << "        { \"p\": [" << s.p.x << ", " << s.p.y << ", " << s.p.z << "], \"h\": " << s.h
+				<< ", \"iterations\": " << s.iterations << " }" << (j + 1 < r.normalTaps.size() ? "," : "") << "\n";
+		}
+
+		out << "      ]\n"
+			<< "    }" << (i + 1 < traces.size() ? "," : "") << "\n";
+	}
+
+	out << "  ]\n}\n";
+	return (bool)out;
+}
+
+bool RayProbe::writePpm(const string &filename, const sf::Vector2u &size, const vector<sf::Uint8> &rgba)
+{
+	ofstream out(filename.c_str(), ios::binary);
+	if (!out) return false;
+
+	out << "P6\n" << size.x << " " << size.y << "\n255\n";
+
+	vector<unsigned char> row(size.x * 3);
+	for (unsigned int y = 0; y < size.y; ++y)
+	{
+		for (unsigned int x = 0; x < size.x; ++x)
+		{
+			for (int c = 0; c < 3; ++c) row[x*3 + c] = rgba[((size_t)y * size.x + x) * 4 + c];
+		}
+		out.write((const char*)&row[0], row.size());
+	}
+
+	return (bool)out;
+}
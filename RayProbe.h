@@ -0,0 +1,45 @@
+#ifndef RAY_PROBE_H
+#define RAY_PROBE_H
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <SFML/System/Vector2.hpp>
+
+#include "ViewState.h"
+#include "CpuMarcher.h"
+
+/*
+ * Why a pixel was expensive. The probed pixels are marched again with
+ * CpuMarcher::tracePixel after the frame, which records t, the distance
+ * estimate, epsilon and the orbit iterations of every step, the six normal
+ * taps and why the march ended. The traces are written as JSON next to the
+ * image they were taken from, pixel coordinates counted from its top left.
+ */
+class RayProbe
+{
+public:
+	RayProbe();
+
+	void addPixel(const int &x, const int &y);
+
+	// Traces every added pixel that lies inside size
+	void trace(const ViewState &view, const sf::Vector2u &size, const CpuMarcher::Quality &quality);
+
+	const vector<CpuMarcher::RayTrace>& getTraces() const;
+	bool writeJson(const string &filename, const string &imageFile, const sf::Vector2u &size) const;
+
+	// The command line tool, returns the exit code. Renders a reference pose
+	// of RenderBenchmark to probe_<pose>.ppm and traces pixels given as x,y.
+	static int run(const string &pose, const vector<string> &pixels);
+
+private:
+	vector<sf::Vector2i> pixels;
+	vector<CpuMarcher::RayTrace> traces;
+
+	static const char* terminationName(const CpuMarcher::Termination &termination);
+	static bool writePpm(const string &filename, const sf::Vector2u &size, const vector<sf::Uint8> &rgba);
+};
+
+#endif /* RAY_PROBE_H */
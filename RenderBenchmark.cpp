@@ -0,0 +1,380 @@
+#include "RenderBenchmark.h"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+using namespace std;
+
+#include <SFML/System/Clock.hpp>
+
+#include "BenchmarkStats.h"
+#include "Camera.h"
+#include "Mandelbulb.h"
+#include "Constants.h"
+
+// Where a ray from ro along rd first comes within EPSILON_LIMIT of the surface
+static Vector3f surfacePoint(const Vector3f &ro, const Vector3f &rd)
+{
+	float t = 0.0f;
+	for (int i = 0; i < 1024; ++i)
+	{
+		float d = sdfMandelbulb(ro + rd * t, POWER);
+		if (d < EPSILON_LIMIT) break;
+		t += d;
+	}
+	return ro + rd * t;
+}
+
+static ViewState pose(const Vector3f &position, const Vector3f &direction)
+{
+	Vector3f dir = Vector3f::normalize(direction);
+	Vector3f right = Vector3f::cross(Vector3f(0.0f, 1.0f, 0.0f), dir).normalize();
+
+	Camera camera((float)BENCH_RENDER_WIDTH, (float)BENCH_RENDER_HEIGHT);
+	camera.position = position;
+
+	ViewState view = ViewState();
+	view.cameraPosition = position;
+	view.cameraDirection = dir;
+	view.cameraUp = Vector3f::cross(dir, right).normalize();
+	view.scale = camera.scale();
+	view.speed = CAM_UNIT_SPEED;
+	view.fogToggle = FOG_ENABLED;
+	view.glowToggle = GLOW_ENABLED;
+	view.heatToggle = false;
+	view.shadowToggle = false;
+	view.aoToggle = false;
+	return view;
+}
+
+vector<pair<string, ViewState>> RenderBenchmark::referencePoses()
+{
+	const Vector3f forward(0.0f, 0.0f, 1.0f);
+	Vector3f hit = surfacePoint(Vector3f(0.3f, 0.2f, -3.0f), forward);
+
+	vector<pair<string, ViewState>> poses;
+	poses.push_back(make_pair(string("far"), pose(Vector3f(0.0f, 0.5f, -6.0f), Vector3f(0.0f, -0.5f, 6.0f))));
+	poses.push_back(make_pair(string("mid"), pose(CAM_INITIAL_POS, forward)));
+	poses.push_back(make_pair(string("grazing"), pose(hit - forward * 0.01f, Vector3f(1.0f, 0.0f, 0.15f))));
+	poses.push_back(make_pair(string("deep"), pose(hit - forward * 2e-4f, forward)));
+	return poses;
+}
+
+RenderBenchmark::RenderBenchmark()
+	: size(BENCH_RENDER_WIDTH, BENCH_RENDER_HEIGHT)
+	, results()
+	, counters()
+{}
+
+int RenderBenchmark::run(const string &jsonFile)
+{
+	// 1, 2, 4, ... and every hardware thread
+	int hardware = max(1, (int)thread::hardware_concurrency());
+	vector<int> threadCounts;
+	for (int n = 1; n < hardware; n *= 2) threadCounts.push_back(n);
+	threadCounts.push_back(hardware);
+
+	if (BENCH_PERF_COUNTERS && !counters.open())
+	{
+		cout << "Hardware counters unavailable, timing only" << endl;
+	}
+	else if (counters.isOpen() && !counters.hasFlops())
+	{
+		cout << "GFLOP/s unavailable, FP_ARITH events need an Intel core from Broadwell on" << endl;
+	}
+
+	const CpuMarcher::Mode modes[] = { CpuMarcher::ScalarMarch, CpuMarcher::PacketMarch, CpuMarcher::WavefrontMarch };
+
+	cout << "Rendering " << size.x << "x" << size.y << ", median of " << BENCH_RENDER_REPEATS << endl;
+	cout << left << setw(10) << "pose" << setw(11) << "mode" << right << setw(8) << "threads" << setw(12) << "wall ms"
+		 << setw(10) << "Mrays/s" << setw(12) << "efficiency" << setw(9) << "speedup" << setw(12) << "steps/ray"
+		 << setw(10) << "p99" << setw(12) << "evals/px";
+	if (counters.isOpen()) cout << setw(8) << "IPC" << setw(12) << "evals/kcyc" << setw(10) << "GFLOP/s";
+	cout << endl;
+
+	vector<sf::Uint8> pixels(size.x * size.y * 4);
+	vector<CpuMarcher::RayCost> costs(size.x * size.y);
+	for (const auto &p : referencePoses())
+	{
+		PoseResult result;
+		result.name = p.first;
+		result.scale = p.second.scale;
+
+		for (const CpuMarcher::Mode &mode : modes)
+		{
+			CpuMarcher::Quality quality;
+			quality.mode = mode;
+
+			const size_t first = result.runs.size();
+			for (int threads : threadCounts)
+			{
+				vector<double> walls;
+				counters.start();
+				for (int i = 0; i < BENCH_RENDER_REPEATS; ++i)
+				{
+					walls.push_back(renderFrame(p.second, size, quality, threads, pixels, costs));
+				}
+
+				Run run;
+				run.counters = counters.stop();
+				run.seconds = 0.0;
+				for (double ms : walls) run.seconds += ms / 1000.0;
+
+				run.mode = mode;
+				run.threads = threads;
+				run.wallMs = percentile(walls, 0.5);
+				run.minWallMs = summarize(walls).min;
+				run.mraysPerSecond = size.x * size.y / (run.wallMs * 1000.0);
+				run.efficiency = result.runs.size() == first ? 1.0 : result.runs[first].wallMs / (threads * run.wallMs);
+				run.speedup = first == 0 ? 1.0 : result.runs[result.runs.size() - first].wallMs / run.wallMs;
+				result.runs.push_back(run);
+			}
+
+			// The march is deterministic, every run cost the same. The
+			// batched modes differ only in the last bits, the scalar march
+			// is what the cost columns report.
+			if (mode != CpuMarcher::ScalarMarch) continue;
+
+			vector<double> steps(costs.size());
+			double evals = 0.0;
+			for (size_t i = 0; i < costs.size(); ++i)
+			{
+				steps[i] = costs[i].steps;
+				evals += costs[i].evals;
+			}
+			result.meanSteps = summarize(steps).mean;
+			result.p99Steps = percentile(steps, 0.99);
+			result.evalsPerPixel = evals / costs.size();
+		}
+
+		// Normals from the estimator against normals from the depths of the
+		// tile, in the default batched mode with every thread
+		CpuMarcher::Quality quality;
+		if (quality.mode == CpuMarcher::ScalarMarch) quality.mode = CpuMarcher::PacketMarch;
+		quality.deferred = true;
+
+		ScreenNormals &screen = result.screenNormals;
+		screen.mode = quality.mode;
+		screen.threads = threadCounts.back();
+		vector<double> deWalls, screenWalls;
+		for (int i = 0; i < BENCH_RENDER_REPEATS; ++i)
+		{
+			quality.screenNormals = false;
+			deWalls.push_back(renderFrame(p.second, size, quality, screen.threads, pixels, costs));
+			quality.screenNormals = true;
+			screenWalls.push_back(renderFrame(p.second, size, quality, screen.threads, pixels, costs));
+		}
+		screen.deMs = percentile(deWalls, 0.5);
+		screen.screenMs = percentile(screenWalls, 0.5);
+		screen.speedup = screen.deMs / screen.screenMs;
+
+		int shaded = 0, fallbacks = 0;
+		for (const auto &c : costs)
+		{
+			if (c.screenNormal) ++shaded;
+			else if (c.normalEvals > 0) ++shaded, ++fallbacks;
+		}
+		screen.fallbackRate = shaded > 0 ? (double)fallbacks / shaded : 0.0;
+
+		// Shadows and occlusion one at a time over the plain frame
+		quality.screenNormals = CpuMarcher::Quality().screenNormals;
+		Lighting &lighting = result.lighting;
+		lighting.mode = quality.mode;
+		lighting.threads = threadCounts.back();
+
+		ViewState view = p.second;
+		vector<double> baseWalls, shadowWalls, aoWalls;
+		double shadowEvals = 0.0, aoEvals = 0.0;
+		for (int i = 0; i < BENCH_RENDER_REPEATS; ++i)
+		{
+			view.shadowToggle = false;
+			view.aoToggle = false;
+			baseWalls.push_back(renderFrame(view, size, quality, lighting.threads, pixels, costs));
+
+			view.shadowToggle = true;
+			shadowWalls.push_back(renderFrame(view, size, quality, lighting.threads, pixels, costs));
+			for (const auto &c : costs) shadowEvals += c.shadowEvals;
+
+			view.shadowToggle = false;
+			view.aoToggle = true;
+			aoWalls.push_back(renderFrame(view, size, quality, lighting.threads, pixels, costs));
+			for (const auto &c : costs) aoEvals += c.aoEvals;
+		}
+		lighting.baseMs = percentile(baseWalls, 0.5);
+		lighting.shadowMs = percentile(shadowWalls, 0.5);
+		lighting.aoMs = percentile(aoWalls, 0.5);
+		lighting.shadowEvalsPerPixel = shadowEvals / ((double)costs.size() * BENCH_RENDER_REPEATS);
+		lighting.aoEvalsPerPixel = aoEvals / ((double)costs.size() * BENCH_RENDER_REPEATS);
+
+		results.push_back(result);
+
+		double repeatEvals = result.evalsPerPixel * costs.size() * BENCH_RENDER_REPEATS;
+		for (const auto &run : result.runs)
+		{
+			cout << left << setw(10) << result.name << setw(11) << CpuMarcher::modeName(run.mode)
+				 << right << fixed << setw(8) << run.threads
+				 << setprecision(1) << setw(12) << run.wallMs
+				 << setprecision(2) << setw(10) << run.mraysPerSecond << setw(12) << run.efficiency << setw(9) << run.speedup
+				 << setw(12) << result.meanSteps << setprecision(0) << setw(10) << result.p99Steps
+				 << setprecision(2) << setw(12) << result.evalsPerPixel;
+			if (counters.isOpen())
+			{
+				const PerfCounters::Reading &c = run.counters;
+				cout << setw(8) << c.instructions / c.cycles << setw(12) << repeatEvals * 1000.0 / c.cycles;
+				if (c.hasFlops) cout << setw(10) << c.flops / run.seconds / 1.0e9;
+				else cout << setw(10) << "-";
+			}
+			cout << endl;
+		}
+	}
+
+	cout << endl << "Screen space normals against estimator normals" << endl;
+	cout << left << setw(10) << "pose" << setw(11) << "mode" << right << setw(8) << "threads" << setw(12) << "de ms"
+		 << setw(12) << "screen ms" << setw(9) << "speedup" << setw(10) << "fallback" << endl;
+	for (const auto &result : results)
+	{
+		const ScreenNormals &screen = result.screenNormals;
+		cout << left << setw(10) << result.name << setw(11) << CpuMarcher::modeName(screen.mode)
+			 << right << fixed << setw(8) << screen.threads
+			 << setprecision(1) << setw(12) << screen.deMs << setw(12) << screen.screenMs
+			 << setprecision(2) << setw(9) << screen.speedup
+			 << setprecision(1) << setw(9) << screen.fallbackRate * 100.0 << "%" << endl;
+	}
+
+	cout << endl << "Soft shadows and ambient occlusion, added to the plain frame" << endl;
+	cout << left << setw(10) << "pose" << setw(11) << "mode" << right << setw(8) << "threads" << setw(12) << "plain ms"
+		 << setw(12) << "shadow ms" << setw(12) << "evals/px" << setw(12) << "ao ms" << setw(12) << "evals/px" << endl;
+	for (const auto &result : results)
+	{
+		const Lighting &lighting = result.lighting;
+		cout << left << setw(10) << result.name << setw(11) << CpuMarcher::modeName(lighting.mode)
+			 << right << fixed << setw(8) << lighting.threads
+			 << setprecision(1) << setw(12) << lighting.baseMs
+			 << showpos << setw(12) << lighting.shadowMs - lighting.baseMs << noshowpos
+			 << setprecision(2) << setw(12) << lighting.shadowEvalsPerPixel
+			 << setprecision(1) << showpos << setw(12) << lighting.aoMs - lighting.baseMs << noshowpos
+			 << setprecision(2) << setw(12) << lighting.aoEvalsPerPixel << endl;
+	}
+
+	if (!writeJson(jsonFile))
+	{
+		cout << "Unable to write " << jsonFile << endl;
+		return EXIT_FAILURE;
+	}
+
+	cout << "Results written to " << jsonFile << endl;
+	return EXIT_SUCCESS;
+}
+
+double RenderBenchmark::renderFrame(const ViewState &view, const sf::Vector2u &size, const CpuMarcher::Quality &quality,
+	const int &threads, vector<sf::Uint8> &pixels, vector<CpuMarcher::RayCost> &costs)
+{
+	const int tilesX = (size.x + CPU_TILE_SIZE - 1) / CPU_TILE_SIZE;
+	const int tilesY = (size.y + CPU_TILE_SIZE - 1) / CPU_TILE_SIZE;
+	const int tileCount = tilesX * tilesY;
+
+	vector<int> order;
+	PixelOrder::build(quality.tileOrder, tilesX, tilesY, order);
+	atomic<int> nextTile(0);
+
+	auto work = [&]() {
+		CpuMarcher marcher;
+		marcher.setView(view, size);
+		marcher.setQuality(quality);
+
+		for (int next = nextTile++; next < tileCount; next = nextTile++)
+		{
+			int index = order[next];
+			int x0 = (index % tilesX) * CPU_TILE_SIZE;
+			int y0 = (index / tilesX) * CPU_TILE_SIZE;
+			int x1 = min(x0 + CPU_TILE_SIZE, (int)size.x);
+			int y1 = min(y0 + CPU_TILE_SIZE, (int)size.y);
+
+			size_t i = (size_t)y0 * size.x + x0;
+			marcher.marchBlock(x0, y0, x1 - x0, y1 - y0, &pixels[i * 4], size.x, &costs[i]);
+		}
+	};
+
+	sf::Clock clock;
+	vector<thread> workers;
+	for (int i = 0; i < threads; ++i) workers.push_back(thread(work));
+	for (auto &w : workers) w.join();
+
+	return clock.getElapsedTime().asMicroseconds() / 1000.0;
+}
+
+bool RenderBenchmark::writeJson(const string &filename) const
+{
+	ofstream out(filename.c_str());
+	if (!out) return false;
+
+	out << "{\n"
+		<< "  \"benchmark\": \"render\",\n"
+		<< "  \"width\": " << size.x << ",\n"
+		<< "  \"height\": " << size.y << ",\n"
+		<< "  \"repeats\": " << BENCH_RENDER_REPEATS << ",\n"
+		<< "  \"poses\": [\n";
+
+	out << setprecision(6);
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const PoseResult &p = results[i];
+		out << "    {\n"
+			<< "      \"pose\": \"" << p.name << "\",\n"
+			<< "      \"scale\": " << p.scale << ",\n"
+			<< "      \"steps_per_ray\": " << p.meanSteps << ",\n"
+			<< "      \"p99_steps_per_ray\": " << p.p99Steps << ",\n"
+			<< "      \"evals_per_pixel\": " << p.evalsPerPixel << ",\n"
+			<< "      \"screen_normals\": { \"mode\": \"" << CpuMarcher::modeName(p.screenNormals.mode) << "\""
+			<< ", \"threads\": " << p.screenNormals.threads
+			<< ", \"de_wall_ms\": " << p.screenNormals.deMs
+			<< ", \"screen_wall_ms\": " << p.screenNormals.screenMs
+			<< ", \"speedup\": " << p.screenNormals.speedup
+			<< ", \"fallback_rate\": " << p.screenNormals.fallbackRate << " },\n"
+			<< "      \"lighting\": { \"mode\": \"" << CpuMarcher::modeName(p.lighting.mode) << "\""
+			<< ", \"threads\": " << p.lighting.threads
+			<< ", \"plain_wall_ms\": " << p.lighting.baseMs
+			<< ", \"shadow_wall_ms\": " << p.lighting.shadowMs
+			<< ", \"shadow_evals_per_pixel\": " << p.lighting.shadowEvalsPerPixel
+			<< ", \"ao_wall_ms\": " << p.lighting.aoMs
+			<< ", \"ao_evals_per_pixel\": " << p.lighting.aoEvalsPerPixel << " },\n"
+			<< "      \"runs\": [\n";
+
+		for (size_t j = 0; j < p.runs.size(); ++j)
+		{
+			const Run &r = p.runs[j];
+			out << "        { \"mode\": \"" << CpuMarcher::modeName(r.mode) << "\""
+				<< ", \"threads\": " << r.threads
+				<< ", \"wall_ms\": " << r.wallMs
+				<< ", \"min_wall_ms\": " << r.minWallMs
+				<< ", \"mrays_per_second\": " << r.mraysPerSecond
+				<< ", \"efficiency\": " << r.efficiency
+				<< ", \"speedup\": " << r.speedup;
+
+			if (counters.isOpen())
+			{
+				const PerfCounters::Reading &c = r.counters;
+				double evals = p.evalsPerPixel * size.x * size.y * BENCH_RENDER_REPEATS;
+				out << ", \"counters\": { \"cycles\": " << c.cycles
+					<< ", \"instructions\": " << c.instructions
+					<< ", \"ipc\": " << c.instructions / c.cycles
+					<< ", \"evals_per_cycle\": " << evals / c.cycles
+					<< ", \"cache_misses_per_ray\": " << c.cacheMisses / (size.x * size.y * BENCH_RENDER_REPEATS)
+					<< ", \"branch_misses_per_ray\": " << c.branchMisses / (size.x * size.y * BENCH_RENDER_REPEATS);
+				if (c.hasFlops) out << ", \"gflops\": " << c.flops / r.seconds / 1.0e9;
+				out << " }";
+			}
+
+			out << " }" << (j + 1 < p.runs.size() ? "," : "") << "\n";
+		}
+
+		out << "      ]\n"
+			<< "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+
+	out << "  ]\n}\n";
+	return (bool)out;
+}
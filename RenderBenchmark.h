@@ -0,0 +1,98 @@
+#ifndef RENDER_BENCHMARK_H
+#define RENDER_BENCHMARK_H
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <SFML/System/Vector2.hpp>
+
+#include "ViewState.h"
+#include "CpuMarcher.h"
+#include "PerfCounters.h"
+
+/*
+ * End to end throughput of the CPU march. A fixed set of reference poses,
+ * from the whole bulb down to a grazing view and a deep zoom, is rendered at
+ * BENCH_RENDER_WIDTH x BENCH_RENDER_HEIGHT with 1 up to every hardware
+ * thread, in tiles the way CpuRenderer splits a frame, once per march mode so
+ * scalar, packet and wavefront marching can be compared. Reports wall time,
+ * Mrays/s, steps per ray, distance estimates per pixel and how well the
+ * threads scale, plus IPC and GFLOP/s where hardware counters can be read.
+ * Screen space normals are timed against estimator normals, shadows and
+ * ambient occlusion against neither, separately.
+ */
+class RenderBenchmark
+{
+public:
+	RenderBenchmark();
+
+	// Prints a table and writes the results as JSON, returns the exit code
+	int run(const string &jsonFile);
+
+	// The reference poses, also used by the other offline tools
+	static vector<pair<string, ViewState>> referencePoses();
+
+	// Milliseconds to march one frame into pixels and costs, both sized
+	// to match. Threads claim CPU_TILE_SIZE tiles along quality.tileOrder.
+	static double renderFrame(const ViewState &view, const sf::Vector2u &size, const CpuMarcher::Quality &quality,
+		const int &threads, vector<sf::Uint8> &pixels, vector<CpuMarcher::RayCost> &costs);
+
+private:
+	struct Run
+	{
+		CpuMarcher::Mode mode;
+		int threads;
+		double wallMs;      // Median of BENCH_RENDER_REPEATS
+		double minWallMs;
+		double mraysPerSecond;
+		double efficiency;  // Single thread time of the mode over threads times this time
+		double speedup;     // Scalar march time at the same thread count over this time
+		double seconds;     // All repeats, what the counters cover
+		PerfCounters::Reading counters;
+	};
+
+	// The default march mode with deferred normals from the distance
+	// estimator against normals from the depth buffer
+	struct ScreenNormals
+	{
+		CpuMarcher::Mode mode;
+		int threads;
+		double deMs;
+		double screenMs;
+		double speedup;
+		double fallbackRate;  // Shaded pixels that still took the estimator's normal
+	};
+
+	// What soft shadows and ambient occlusion add to a frame, each on its own
+	struct Lighting
+	{
+		CpuMarcher::Mode mode;
+		int threads;
+		double baseMs;
+		double shadowMs;
+		double aoMs;
+		double shadowEvalsPerPixel;
+		double aoEvalsPerPixel;
+	};
+
+	struct PoseResult
+	{
+		string name;
+		float scale;
+		double meanSteps;
+		double p99Steps;
+		double evalsPerPixel;
+		vector<Run> runs;
+		ScreenNormals screenNormals;
+		Lighting lighting;
+	};
+
+	sf::Vector2u size;
+	vector<PoseResult> results;
+	PerfCounters counters;
+
+	bool writeJson(const string &filename) const;
+};
+
+#endif /* RENDER_BENCHMARK_H */
@@ -0,0 +1,65 @@
+#include "ShaderSource.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+using namespace std;
+
+static string directoryOf(const string &path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return slash == string::npos ? string() : path.substr(0, slash + 1);
+}
+
+static bool loadShaderSource(const string &path, string &source, const int &depth)
+{
+	// Guard against include cycles
+	if (depth > 8)
+	{
+		cout << "Shader includes nested too deep at " << path << endl;
+		return false;
+	}
+
+	ifstream in(path.c_str());
+	if (!in)
+	{
+		cout << "Unable to open shader source " << path << endl;
+		return false;
+	}
+
+	const string directive = "#include";
+	stringstream out;
+	string line;
+	while (getline(in, line))
+	{
+		size_t start = line.find_first_not_of(" \t");
+		if (start != string::npos && line.compare(start, directive.size(), directive) == 0)
+		{
+			size_t open = line.find('"', start);
+			size_t close = line.find('"', open + 1);
+			if (open == string::npos || close == string::npos)
+			{
+				cout << "Malformed include in " << path << ": " << line << endl;
+				return false;
+			}
+
+			string included;
+			if (!loadShaderSource(directoryOf(path) + line.substr(open + 1, close - open - 1), included, depth + 1))
+				return false;
+
+			out << included << "\n";
+		}
+		else
+		{
+			out << line << "\n";
+		}
+	}
+
+	source = out.str();
+	return true;
+}
+
+bool loadShaderSource(const string &path, string &source)
+{
+	return loadShaderSource(path, source, 0);
+}
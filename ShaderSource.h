@@ -0,0 +1,12 @@
+#ifndef SHADER_SOURCE_H
+#define SHADER_SOURCE_H
+
+#include <string>
+using namespace std;
+
+// Reads a GLSL file, replacing every `#include "file"` line with the contents
+// of that file (resolved next to the including file). GLSL has no include of
+// its own, this lets the fragment and compute paths share the march code.
+bool loadShaderSource(const string &path, string &source);
+
+#endif /* SHADER_SOURCE_H */
@@ -0,0 +1,105 @@
+#include "SteadyStateCheck.h"
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+using namespace std;
+
+#include <SFML/System/Clock.hpp>
+
+#include "AllocTracker.h"
+#include "CpuRenderer.h"
+#include "FrameStats.h"
+#include "InfoText.h"
+#include "RenderBenchmark.h"
+#include "Constants.h"
+
+// Waits for the renderer to publish another frame, false once it stalls
+static bool waitForFrame(const CpuRenderer &renderer, const int &finished)
+{
+	sf::Clock clock;
+	while (renderer.getFinishedFrames() <= finished)
+	{
+		if (clock.getElapsedTime().asSeconds() > STEADY_CHECK_TIMEOUT) return false;
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+	return true;
+}
+
+int SteadyStateCheck::run()
+{
+	const sf::Vector2u size(STEADY_CHECK_WIDTH, STEADY_CHECK_HEIGHT);
+	const int frameCount = ALLOC_WARMUP_FRAMES + STEADY_CHECK_FRAMES;
+
+	// Everything the loop touches is built up front
+	ViewState view = RenderBenchmark::referencePoses()[1].second;
+	const Vector3f start = view.cameraPosition;
+	FrameStats stats(FRAME_STATS_HISTORY);
+	InfoText text;
+	CpuRenderer renderer;
+
+	AllocTracker::setEnabled(true);
+	renderer.start(CPU_RENDER_THREADS);
+
+	int allocatingFrames = 0;
+	long long allocations = 0;
+	sf::Clock clock;
+	for (int frame = 0; frame < frameCount; ++frame)
+	{
+		if (frame == ALLOC_WARMUP_FRAMES) AllocTracker::resetSites();
+		AllocTracker::Counts before = AllocTracker::total();
+
+		// Forward and back, so most frames march new tiles and some reuse them
+		float along = (float)(frame % 40 < 20 ? frame % 40 : 40 - frame % 40) / 20.0f;
+		view.cameraPosition = start + view.cameraDirection * (along * 0.2f);
+
+		int finished = renderer.getFinishedFrames();
+		renderer.request(view, size);
+		if (!waitForFrame(renderer, finished))
+		{
+			renderer.stop();
+			AllocTracker::setEnabled(false);
+			cout << "Steady state unchecked, the CPU renderer stalled at frame " << frame << endl;
+			return EXIT_FAILURE;
+		}
+
+		stats.addFrame(clock.restart().asSeconds());
+
+		// The lines the HUD shows on the CPU path
+		text.clear();
+		text.append("fps: %g\n", 1.0f / stats.getMeanFrameTime());
+		text.append("path: cpu, %d threads\n", renderer.getThreadCount());
+		text.append("cpu frame: %g ms\n", renderer.getFrameTime());
+		text.append("tiles cancelled: %d, reused: %d\n", renderer.getCancelledTiles(), renderer.getReusedTiles());
+		text.append("frames superseded: %d\n", renderer.getSupersededFrames());
+		text.append("speculation: %d hits, %d misses\n", renderer.getSpeculationHits(), renderer.getSpeculationMisses());
+		text.append("frame time: %g ms mean, %g ms p99\n", stats.getMeanFrameTime() * 1000.0f, stats.getPercentileFrameTime(0.99f) * 1000.0f);
+		text.append("heap: %lld allocations last frame\n", allocations);
+		text.append("frames allocating after warm-up: %d\n", allocatingFrames);
+		text.append("scale: %g\n", view.scale);
+
+		AllocTracker::Counts after = AllocTracker::total();
+		allocations = after.allocations - before.allocations;
+		if (frame < ALLOC_WARMUP_FRAMES || allocations == 0) continue;
+
+		if (++allocatingFrames == 1)
+		{
+			cout << "Steady state broken: frame " << frame << " allocated " << allocations << " times" << endl;
+		}
+	}
+
+	renderer.stop();
+	AllocTracker::setEnabled(false);
+
+	if (allocatingFrames == 0)
+	{
+		cout << "Steady state held: no allocations in " << STEADY_CHECK_FRAMES << " frames after "
+			<< ALLOC_WARMUP_FRAMES << " warm-up frames" << endl;
+		return EXIT_SUCCESS;
+	}
+
+	cout << "Steady state broken: " << allocatingFrames << " of " << STEADY_CHECK_FRAMES << " frames allocated" << endl;
+	AllocTracker::printSites(cout, ALLOC_REPORT_SITES);
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,18 @@
+#ifndef STEADY_STATE_CHECK_H
+#define STEADY_STATE_CHECK_H
+
+/*
+ * The zero allocation steady state without a window or a GPU. Flies the CPU
+ * renderer along a short path at STEADY_CHECK_WIDTH x STEADY_CHECK_HEIGHT,
+ * waiting for every frame to finish, and builds the HUD text of the CPU
+ * path after each one. After ALLOC_WARMUP_FRAMES frames, every further frame
+ * must leave the allocation counts of all threads unchanged.
+ */
+class SteadyStateCheck
+{
+public:
+	// Prints the frames that allocated and their call sites, returns the exit code
+	static int run();
+};
+
+#endif /* STEADY_STATE_CHECK_H */
@@ -0,0 +1,71 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+/*
+ * Lock-free single producer, single consumer hand-off of the latest value.
+ * The writer fills its back slot and publishes it by swapping it with the
+ * middle slot, the reader swaps the middle slot into its front slot when a
+ * newer value is waiting. Neither side ever blocks, and the reader always
+ * sees a complete value, skipping any it was too slow to pick up.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer()
+		: slots()
+		, middle(1)
+		, back(0)
+		, front(2)
+		, published(1)
+	{}
+
+	// Writer side
+	T& getWriteBuffer()
+	{
+		return slots[back];
+	}
+
+	void publish()
+	{
+		published = back;
+		int previous = middle.exchange(back | DIRTY, std::memory_order_acq_rel);
+		back = previous & INDEX;
+	}
+
+	// The value last published, the reader may be reading it too but no one
+	// writes it until the writer gets it back after the next publish
+	const T& getPublished() const
+	{
+		return slots[published];
+	}
+
+	// Reader side, returns true when a newer value became readable
+	bool consume()
+	{
+		if ((middle.load(std::memory_order_acquire) & DIRTY) == 0) return false;
+
+		int previous = middle.exchange(front, std::memory_order_acq_rel);
+		front = previous & INDEX;
+		return true;
+	}
+
+	const T& getReadBuffer() const
+	{
+		return slots[front];
+	}
+
+private:
+	static const int INDEX = 0x3;
+	static const int DIRTY = 0x4;
+
+	T slots[3];
+	std::atomic<int> middle;
+	int back;
+	int front;
+	int published;
+};
+
+#endif /* TRIPLE_BUFFER_H */
@@ -1,10 +1,16 @@
 #ifndef VECTOR_3F_H
 #define VECTOR_3F_H
 
+#include <cmath>
+
 #include <SFML/System/Vector3.hpp>
 
 class Matrix4;
 
+/*
+ * Everything but the matrix and rotation helpers is defined inline below, so
+ * the marchers and the camera code can inline it across translation units.
+ */
 class Vector3f
 {
 public:
@@ -12,13 +18,13 @@ public:
 	float y;
 	float z;
 
-	Vector3f();
-	Vector3f(float x, float y, float z);
-	Vector3f(const Vector3f &other);
-	Vector3f(Vector3f &&other);
+	constexpr Vector3f();
+	constexpr Vector3f(float x, float y, float z);
+	Vector3f(const Vector3f &other) = default;
+	Vector3f(Vector3f &&other) = default;
 	
-	Vector3f& operator=(const Vector3f &b);
-	Vector3f& operator=(Vector3f &&b);
+	Vector3f& operator=(const Vector3f &b) = default;
+	Vector3f& operator=(Vector3f &&b) = default;
 
 	sf::Vector3f asSFML() const;
 
@@ -26,7 +32,7 @@ public:
 	Vector3f& set(const Vector3f &u);
 
 	float length() const;
-	float dot(const Vector3f &b) const;
+	constexpr float dot(const Vector3f &b) const;
 
 	Vector3f& add(const Vector3f &b);
 	Vector3f& sub(const Vector3f &b);
@@ -37,16 +43,16 @@ public:
 	static Vector3f normalize(const Vector3f &v);
 
 	Vector3f& cross(const Vector3f &b);
-	static Vector3f cross(const Vector3f &a, const Vector3f &b);
+	static constexpr Vector3f cross(const Vector3f &a, const Vector3f &b);
 
 	Vector3f& rot(const Matrix4& matrix);
 	Vector3f& rotate(const float &degrees, const float &axisX, const float &axisY, const float &axisZ);
 	Vector3f& rotate(const Vector3f& axis, const float &degrees);
 
-	Vector3f operator+(const Vector3f &u) const;
-	Vector3f operator-(const Vector3f &u) const;
-	Vector3f operator*(const float &s) const;
-	Vector3f operator/(const float &s) const;
+	constexpr Vector3f operator+(const Vector3f &u) const;
+	constexpr Vector3f operator-(const Vector3f &u) const;
+	constexpr Vector3f operator*(const float &s) const;
+	constexpr Vector3f operator/(const float &s) const;
 
 	Vector3f& operator+=(const Vector3f &u);
 	Vector3f& operator-=(const Vector3f &u);
@@ -54,4 +60,129 @@ public:
 	Vector3f& operator/=(const float &s);
 };
 
-#endif // VECTOR_3F_H
\ No newline at end of file
+constexpr Vector3f::Vector3f()
+	: x(0.0f), y(0.0f), z(0.0f)
+{}
+
+constexpr Vector3f::Vector3f(float x, float y, float z)
+	: x(x), y(y), z(z)
+{}
+
+inline sf::Vector3f Vector3f::asSFML() const
+{
+	return sf::Vector3f(x, y, z);
+}
+
+inline Vector3f& Vector3f::set(const float &x, const float &y, const float &z)
+{
+	this->x = x;
+	this->y = y;
+	this->z = z;
+	return *this;
+}
+
+inline Vector3f& Vector3f::set(const Vector3f &u)
+{
+	return this->set(u.x, u.y, u.z);
+}
+
+inline float Vector3f::length() const
+{
+	return std::sqrt((x * x) + (y * y) + (z * z));
+}
+
+constexpr float Vector3f::dot(const Vector3f &u) const
+{
+	return x * u.x + y * u.y + z * u.z;
+}
+
+inline Vector3f& Vector3f::add(const Vector3f &b)
+{
+	return *this += b;
+}
+
+inline Vector3f& Vector3f::sub(const Vector3f &b)
+{
+	return *this -= b;
+}
+
+inline Vector3f& Vector3f::normalize()
+{
+	return *this /= length();
+}
+
+inline Vector3f Vector3f::normalize(const Vector3f &v)
+{
+	return Vector3f(v) /= v.length();
+}
+
+inline Vector3f& Vector3f::cross(const Vector3f &u)
+{
+	return this->set(cross(*this, u));
+}
+
+constexpr Vector3f Vector3f::cross(const Vector3f &a, const Vector3f &b)
+{
+	return Vector3f( a.y * b.z - a.z * b.y
+	               , a.z * b.x - a.x * b.z
+	               , a.x * b.y - a.y * b.x
+	               );
+}
+
+constexpr Vector3f Vector3f::operator+(const Vector3f &u) const
+{
+	return Vector3f(x + u.x, y + u.y, z + u.z);
+}
+
+constexpr Vector3f Vector3f::operator-(const Vector3f &u) const
+{
+	return Vector3f(x - u.x, y - u.y, z - u.z);
+}
+
+constexpr Vector3f Vector3f::operator*(const float &s) const
+{
+	return Vector3f(x * s, y * s, z * s);
+}
+
+constexpr Vector3f Vector3f::operator/(const float &s) const
+{
+	return s != 0.0f ? Vector3f(x / s, y / s, z / s) : *this;
+}
+
+inline Vector3f& Vector3f::operator+=(const Vector3f &u)
+{
+	x += u.x;
+	y += u.y;
+	z += u.z;
+	return *this;
+}
+
+inline Vector3f& Vector3f::operator-=(const Vector3f &u)
+{
+	x -= u.x;
+	y -= u.y;
+	z -= u.z;
+	return *this;
+}
+
+inline Vector3f& Vector3f::operator*=(const float &s)
+{
+	x *= s;
+	y *= s;
+	z *= s;
+	return *this;
+}
+
+inline Vector3f& Vector3f::operator/=(const float &s)
+{
+	if (s != 0.0f)
+	{
+		x /= s;
+		y /= s;
+		z /= s;
+	}
+
+	return *this;
+}
+
+#endif // VECTOR_3F_H
@@ -0,0 +1,28 @@
+#ifndef VIEW_STATE_H
+#define VIEW_STATE_H
+
+#include "Vector3f.h"
+
+// Everything a frame is drawn from, copied out of the simulation every tick
+struct ViewState
+{
+	Vector3f cameraPosition;
+	Vector3f cameraDirection;
+	Vector3f cameraUp;
+	Vector3f cameraVelocity;
+	float scale;
+	float speed;
+	float mindist;
+
+	bool infoToggle;
+	bool fogToggle;
+	bool glowToggle;
+	bool heatToggle;
+	bool shadowToggle;
+	bool aoToggle;
+	bool captureToggle;
+	bool computeToggle;
+	bool warpToggle;
+};
+
+#endif /* VIEW_STATE_H */
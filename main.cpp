@@ -1,10 +1,69 @@
 #include <string>
+#include <iostream>
+#include <cstdlib>
 using namespace std;
 
 #include "MandelbulbViewer.h"
+#include "KernelBenchmark.h"
+#include "RenderBenchmark.h"
+#include "DistanceAccuracy.h"
+#include "CostAtlas.h"
+#include "ParameterSweep.h"
+#include "RayProbe.h"
+#include "SteadyStateCheck.h"
 #include "Constants.h"
 
 int main (int argc, char** argv){
+	// Needs no window
+	if (argc > 1 && string(argv[1]) == "--bench-kernels")
+		return KernelBenchmark().run(argc > 2 ? argv[2] : KERNEL_BENCH_FILE);
+
+	if (argc > 1 && string(argv[1]) == "--bench-render")
+		return RenderBenchmark().run(argc > 2 ? argv[2] : RENDER_BENCH_FILE);
+
+	if (argc > 1 && string(argv[1]) == "--check-accuracy")
+		return DistanceAccuracy().run(argc > 2 ? argv[2] : ACCURACY_FILE);
+
+	if (argc > 1 && string(argv[1]) == "--cost-atlas")
+		return CostAtlas::exportReferencePoses(argc > 2 ? argv[2] : COST_ATLAS_PREFIX);
+
+	if (argc > 1 && string(argv[1]) == "--cost-summary")
+	{
+		if (argc > 2) return CostAtlas::summarizeFile(argv[2]);
+		cout << "Usage: --cost-summary <prefix>, for example --cost-summary cost_grazing" << endl;
+		return EXIT_FAILURE;
+	}
+
+	if (argc > 1 && string(argv[1]) == "--sweep")
+		return ParameterSweep().run(argc > 2 ? argv[2] : SWEEP_FILE);
+
+	if (argc > 1 && string(argv[1]) == "--probe")
+	{
+		if (argc > 3) return RayProbe::run(argv[2], vector<string>(argv + 3, argv + argc));
+		cout << "Usage: --probe <far|mid|grazing|deep> <x,y> [x,y ...]" << endl;
+		return EXIT_FAILURE;
+	}
+
+	if (argc > 1 && string(argv[1]) == "--check-steady-state")
+		return SteadyStateCheck::run();
+
 	MandelbulbViewer viewer(SCREEN_WIDTH, SCREEN_HEIGHT, DEFAULT_FPS);
+
+	// May follow any of the modes below
+	if (argc > 1 && string(argv[argc - 1]) == "--steady-state")
+	{
+		viewer.setSteadyState(true);
+		--argc;
+	}
+
+	if (argc > 1 && string(argv[1]) == "--verify-compute")
+		return viewer.verifyCompute();
+
+	if (argc > 1 && string(argv[1]) == "--cpu")
+		viewer.setCpuBackend(true);
+
+	if (argc > 2 && string(argv[1]) == "--playback")
+		return viewer.playback(argv[2]);
+
 	return viewer.run();
 }
\ No newline at end of file
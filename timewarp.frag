@@ -0,0 +1,60 @@
+#version 400
+
+#include "mandelbulb_march.glsl"
+
+// Reprojects the last frame the async marcher finished to the current camera.
+// camera_* is where the frame is shown from, source_* where it was marched from.
+
+uniform sampler2D color_frame;
+uniform sampler2D depth_frame;
+
+uniform vec3 source_position;
+uniform vec3 source_direction;
+uniform vec3 source_up;
+
+const int WARP_ITERATIONS = 3;
+
+in vec3 Color;
+out vec4 o_color;
+
+
+// Inverse of camera_ray for the source camera, w is false behind it
+vec3 project_source(in vec3 d)
+{
+	vec3 right = normalize(cross(source_up, source_direction));
+	vec3 local = vec3(dot(d, right), dot(d, source_up), dot(d, source_direction));
+	float tan_half = tan(fov * M_PI / 360.0);
+
+	float px = local.x / local.z / (tan_half * aspect);
+	float py = local.y / local.z / tan_half;
+
+	return vec3((px + 1.0) * screen_width / 2.0 - 0.5, (1.0 - py) * screen_height / 2.0 - 0.5, local.z);
+}
+
+
+void main()
+{
+	vec2 size = vec2(screen_width, screen_height);
+	vec3 rd = primary_ray(gl_FragCoord.xy);
+
+	// Same direction in the source frame, exact for the sky and for pure rotation
+	vec3 coord = project_source(rd);
+
+	// With the camera moved, look up the surface point that pixel saw, slide it
+	// onto the current ray and project that instead. A few rounds settle on
+	// the surface the current ray actually crosses.
+	for (int i = 0; i < WARP_ITERATIONS && coord.z > 0.0; ++i)
+	{
+		float t = texture(depth_frame, coord.xy / size).r;
+		if (t < 0.0) break;
+
+		vec3 p = source_position + camera_ray(coord.xy, source_direction, source_up) * t;
+		vec3 q = camera_position + rd * max(dot(p - camera_position, rd), 0.0);
+		coord = project_source(q - source_position);
+	}
+
+	vec2 uv = coord.xy / size;
+	bool inside = coord.z > 0.0 && all(greaterThanEqual(uv, vec2(0.0))) && all(lessThanEqual(uv, vec2(1.0)));
+
+	o_color = inside ? vec4(texture(color_frame, uv).rgb, 1.0) : vec4(SKY_COLOR, 1.0);
+}